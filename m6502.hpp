@@ -27,17 +27,77 @@
 
 #ifndef INCLUDE_M6502_HPP
 #define INCLUDE_M6502_HPP
+#include <algorithm>
+#include <ctype.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <utility>
 #include <vector>
 
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define M6502_JIT_SUPPORTED
+#endif
+
 /**
  * Emulation modes
  */
 #define M6502_MODE_NORMAL 0 // Normal MOS6502 emulation
 #define M6502_MODE_RP2A03 1 // Ricoh 2A03 emulation
+#define M6502_MODE_RUNTIME -1 // Decided by the constructor argument (M6502T template argument only)
+
+/**
+ * Features (specify the combination to the M6502T template argument)
+ * The branches of the features that are not specified are compiled out from the core.
+ */
+#define M6502_FEATURE_DEBUG 0x0001 // setDebugMessage
+#define M6502_FEATURE_BREAK 0x0002 // addBreakPoint, addBreakOperand, addWatchPoint
+#define M6502_FEATURE_CLOCK 0x0004 // setConsumeClock, setConsumeClocks
+#define M6502_FEATURE_ERROR 0x0008 // setOnError
+#define M6502_FEATURE_PREDECODE 0x0010 // addPredecodeArea
+#define M6502_FEATURE_LAZY_FLAGS 0x0020 // evaluate N and Z lazily (R.p is coherent when the callbacks except the memory bus are called and after execute)
+#define M6502_FEATURE_LOW_MEMORY 0x0040 // setLowMemory
+#define M6502_FEATURE_IDLE_SKIP 0x0080  // addStableArea
+#define M6502_FEATURE_CLOCK_SYNC 0x0100 // addClockSyncArea, addCatchUp
+#define M6502_FEATURE_TRACE 0x0200      // setTrace
+#define M6502_FEATURE_DEFAULT (M6502_FEATURE_DEBUG | M6502_FEATURE_BREAK | M6502_FEATURE_CLOCK | M6502_FEATURE_ERROR)
+#define M6502_FEATURE_RELEASE 0
+
+/**
+ * Memory accesses to watch (specify the combination to addWatchPoint)
+ */
+#define M6502_WATCH_READ 0x01
+#define M6502_WATCH_WRITE 0x02
+
+/**
+ * Maximum stack depth to evaluate a condition of the break point
+ */
+#define M6502_CONDITION_STACK 32
+
+/**
+ * Execution engines (specify to setEngine)
+ */
+#define M6502_ENGINE_TABLE 0  // Dispatch by the function pointer table (default)
+#define M6502_ENGINE_SWITCH 1 // Dispatch by a switch statement that inlines all operations into a function
+#define M6502_ENGINE_BLOCK 2  // Execute the predecoded basic blocks (same as TABLE if M6502_FEATURE_PREDECODE is not specified)
+#define M6502_ENGINE_JIT 3    // Translate the hot basic blocks into x86-64 machine code (same as BLOCK on other platforms)
+
+/**
+ * Maximum number of operations in a basic block (M6502_ENGINE_BLOCK)
+ */
+#define M6502_BLOCK_MAX_OPERATIONS 32
+
+/**
+ * Number of executions until a basic block is translated (M6502_ENGINE_JIT)
+ */
+#define M6502_JIT_THRESHOLD 16
+
+/**
+ * Size of the executable memory for the translated code (M6502_ENGINE_JIT)
+ */
+#define M6502_JIT_BUFFER_SIZE (1024 * 1024)
 
 /**
  * Error codes
@@ -45,18 +105,422 @@
 #define M6502_ERROR_UNKNOWN_OPERAND 0xDEAD0001 // Unknown operation
 #define M6502_ERROR_BRANCH_ZERO 0xDEAD0002     // Relative address of branch operand has zero
 
-class M6502
+/**
+ * Memory bus adapter that routes the bus accesses to the callback functions
+ * (used by the M6502 class)
+ */
+class M6502CallbackBus
+{
+  public:
+    unsigned char (*readMemory)(void* arg, unsigned short addr);
+    void (*writeMemory)(void* arg, unsigned short addr, unsigned char value);
+    void* arg;
+
+    M6502CallbackBus(unsigned char (*readMemory)(void* arg, unsigned short addr), void (*writeMemory)(void* arg, unsigned short addr, unsigned char value), void* arg)
+    {
+        this->readMemory = readMemory;
+        this->writeMemory = writeMemory;
+        this->arg = arg;
+    }
+
+    inline unsigned char read(unsigned short addr) { return readMemory ? readMemory(arg, addr) : 0; }
+    inline void write(unsigned short addr, unsigned char value)
+    {
+        if (writeMemory) writeMemory(arg, addr, value);
+    }
+};
+
+/**
+ * Memory bus adapter with a page table (opt-in: M6502T<M6502PagedBus>)
+ * The pages mapped by mapMemory are accessed directly without calling the callback functions.
+ */
+class M6502PagedBus : public M6502CallbackBus
+{
+  public:
+    unsigned char* readPages[256];  // host memory of each page (NULL: call readMemory)
+    unsigned char* writePages[256]; // host memory of each page (NULL: call writeMemory)
+
+    M6502PagedBus(unsigned char (*readMemory)(void* arg, unsigned short addr), void (*writeMemory)(void* arg, unsigned short addr, unsigned char value), void* arg)
+        : M6502CallbackBus(readMemory, writeMemory, arg)
+    {
+        memset(readPages, 0, sizeof(readPages));
+        memset(writePages, 0, sizeof(writePages));
+    }
+
+    /**
+     * Map a host memory to the pages (RAM or ROM)
+     * - [i] addrFrom: start address (must be the head of a page: $xx00)
+     * - [i] addrTo: end address (must be the tail of a page: $xxFF)
+     * - [i] memory: host memory of addrFrom
+     * - [i] writable: true = RAM, false = ROM (writing to ROM calls writeMemory, e.g. for bank switching)
+     * - return: false = the area is not page aligned (nothing is mapped)
+     */
+    bool mapMemory(unsigned short addrFrom, unsigned short addrTo, unsigned char* memory, bool writable)
+    {
+        if (!isPageAligned(addrFrom, addrTo)) return false;
+        for (int page = addrFrom >> 8; page <= addrTo >> 8; page++) {
+            readPages[page] = memory + ((page - (addrFrom >> 8)) << 8);
+            writePages[page] = writable ? readPages[page] : NULL;
+        }
+        return true;
+    }
+
+    /**
+     * Unmap the pages (the callback functions will be called again, e.g. for I/O)
+     * - [i] addrFrom: start address (must be the head of a page: $xx00)
+     * - [i] addrTo: end address (must be the tail of a page: $xxFF)
+     * - return: false = the area is not page aligned (nothing is unmapped)
+     */
+    bool unmapMemory(unsigned short addrFrom, unsigned short addrTo)
+    {
+        if (!isPageAligned(addrFrom, addrTo)) return false;
+        for (int page = addrFrom >> 8; page <= addrTo >> 8; page++) {
+            readPages[page] = NULL;
+            writePages[page] = NULL;
+        }
+        return true;
+    }
+
+  private:
+    static inline bool isPageAligned(unsigned short addrFrom, unsigned short addrTo)
+    {
+        return (addrFrom & 0xFF) == 0 && (addrTo & 0xFF) == 0xFF && addrFrom <= addrTo;
+    }
+
+  public:
+    inline unsigned char read(unsigned short addr)
+    {
+        unsigned char* page = readPages[addr >> 8];
+        if (page) return page[addr & 0xFF];
+        return M6502CallbackBus::read(addr);
+    }
+    inline bool read16(unsigned short addr, unsigned short* value)
+    {
+        unsigned char* page = readPages[addr >> 8];
+        if (!page || (addr & 0xFF) == 0xFF) return false; // not mapped or crosses the page
+        *value = page[addr & 0xFF] | (page[(addr & 0xFF) + 1] << 8);
+        return true;
+    }
+    inline bool peek(unsigned short addr, unsigned char* value)
+    {
+        unsigned char* page = readPages[addr >> 8];
+        if (!page) return false; // not mapped (the callback may have side effects)
+        *value = page[addr & 0xFF];
+        return true;
+    }
+    inline void write(unsigned short addr, unsigned char value)
+    {
+        unsigned char* page = writePages[addr >> 8];
+        if (page) {
+            page[addr & 0xFF] = value;
+        } else {
+            M6502CallbackBus::write(addr, value);
+        }
+    }
+};
+
+/**
+ * Optional 16-bit read of the Bus: bool read16(unsigned short addr, unsigned short* value)
+ * It reads 2 bytes (little endian) at once and returns false if they must be read one by one (e.g. I/O).
+ */
+template <class Bus, class = void>
+struct M6502BusRead16 {
+    static const bool supported = false;
+    static inline bool read(Bus&, unsigned short, unsigned short*) { return false; }
+};
+
+template <class Bus>
+struct M6502BusRead16<Bus, decltype((void)std::declval<Bus&>().read16(0, (unsigned short*)NULL))> {
+    static const bool supported = true;
+    static inline bool read(Bus& bus, unsigned short addr, unsigned short* value) { return bus.read16(addr, value); }
+};
+
+/**
+ * Optional peek of the Bus: bool peek(unsigned short addr, unsigned char* value)
+ * It reads a byte without side effects (used by mem[address] of the conditional break points) and returns false if it cannot (e.g. I/O).
+ */
+template <class Bus, class = void>
+struct M6502BusPeek {
+    static inline bool peek(Bus&, unsigned short, unsigned char*) { return false; }
+};
+
+template <class Bus>
+struct M6502BusPeek<Bus, decltype((void)std::declval<Bus&>().peek(0, (unsigned char*)NULL))> {
+    static inline bool peek(Bus& bus, unsigned short addr, unsigned char* value) { return bus.peek(addr, value); }
+};
+
+/**
+ * Precomputed digits of ADC and SBC in the decimal mode (shared by all cores and made at the first use)
+ * Each entry has the result digit (bit 0-3) and the carry (bit 4), and it is indexed by C (bit 8), a digit of A (bit 4-7) and a digit of the value (bit 0-3).
+ * The invalid digits ($A-$F) are calculated as modulo 10.
+ */
+struct M6502DecimalTable {
+    unsigned char adc[0x200];
+    unsigned char sbc[0x200];
+
+    M6502DecimalTable()
+    {
+        for (int i = 0; i < 0x200; i++) {
+            int c = i >> 8;
+            int a = ((i >> 4) & 0x0F) % 10;
+            int v = (i & 0x0F) % 10;
+            // ADC
+            int r = a + v + c;
+            adc[i] = (unsigned char)((r / 10 ? 0x10 : 0) | (r % 10));
+            // SBC
+            r = a - v - (c ? 0 : 1);
+            int carry = 0x10;
+            if (r < 0) {
+                r += 10;
+                carry = 0;
+            }
+            sbc[i] = (unsigned char)(carry | r);
+        }
+    }
+
+    static const M6502DecimalTable& get()
+    {
+        static const M6502DecimalTable table;
+        return table;
+    }
+
+    // calculate the low digit and then the high digit (returns the result in bit 0-7 and the carry in bit 8)
+    static inline unsigned short calculate(const unsigned char* table, unsigned char a, unsigned char value, bool c)
+    {
+        unsigned char low = table[(c ? 0x100 : 0) | ((a & 0x0F) << 4) | (value & 0x0F)];
+        unsigned char high = table[(low & 0x10 ? 0x100 : 0) | (a & 0xF0) | (value >> 4)];
+        return (high & 0x10 ? 0x100 : 0) | ((high & 0x0F) << 4) | (low & 0x0F);
+    }
+};
+
+/**
+ * Trace of an executed operation (see setTrace)
+ */
+struct M6502TraceEvent {
+    struct Registers {
+        unsigned short pc;
+        unsigned char a;
+        unsigned char x;
+        unsigned char y;
+        unsigned char p;
+        unsigned char s;
+    } before, after;
+    unsigned char code[3]; // operation code and operand bytes
+    unsigned char length;  // number of the bytes in code
+    int addr;              // address of the memory operand (-1: none)
+    int cycles;            // number of clocks consumed by the operation
+};
+
+/**
+ * MOS6502 core with a compile-time memory bus
+ * The Bus type must have following inline members (they will be inlined into the core):
+ * - unsigned char read(unsigned short addr)
+ * - void write(unsigned short addr, unsigned char value)
+ * The Mode is the emulation mode (M6502_MODE_XXX) that is fixed at compile-time.
+ * The mode dependent branches will be removed from the hot path when other than M6502_MODE_RUNTIME is specified.
+ * The Features is the combination of M6502_FEATURE_XXX.
+ */
+template <class Bus, int Mode = M6502_MODE_RUNTIME, int Features = M6502_FEATURE_DEFAULT>
+class M6502T
 {
   private:
+    // instructions of the break point conditions (postfix notation)
+    enum ConditionCode {
+        CC_NUM, // push the next code
+        CC_A,
+        CC_X,
+        CC_Y,
+        CC_S,
+        CC_P,
+        CC_PC,
+        CC_HITS,
+        CC_MEM, // replace the address with the memory
+        CC_NOT,
+        CC_NEG,
+        CC_INV,
+        CC_OR,
+        CC_AND,
+        CC_BOR,
+        CC_BXOR,
+        CC_BAND,
+        CC_EQ,
+        CC_NE,
+        CC_LE,
+        CC_GE,
+        CC_LT,
+        CC_GT,
+        CC_ADD,
+        CC_SUB,
+    };
+
+    // compiles a condition such as "A == $40 && X < 3" into the postfix notation
+    class ConditionCompiler
+    {
+      public:
+        const char* ptr;
+        std::vector<int>* code;
+        bool error;
+
+        ConditionCompiler(const char* condition, std::vector<int>* code)
+        {
+            this->ptr = condition;
+            this->code = code;
+            this->error = false;
+        }
+
+        bool compile()
+        {
+            code->clear();
+            compileBinary(1);
+            skipSpace();
+            if (*ptr) error = true;
+            // simulate the stack depth of the evaluation
+            int depth = 0;
+            for (size_t i = 0; !error && i < code->size(); i++) {
+                int op = (*code)[i];
+                if (op == CC_NUM) i++;
+                if (op <= CC_HITS) {
+                    if (M6502_CONDITION_STACK <= depth++) error = true;
+                } else if (CC_OR <= op) {
+                    depth--;
+                }
+            }
+            return !error;
+        }
+
+      private:
+        void skipSpace()
+        {
+            while (*ptr == ' ' || *ptr == '\t') ptr++;
+        }
+
+        bool match(const char* token)
+        {
+            skipSpace();
+            size_t length = strlen(token);
+            if (strncmp(ptr, token, length)) return false;
+            ptr += length;
+            return true;
+        }
+
+        // returns the operator and its precedence (the longer operators are matched first)
+        int peekBinary(int* precedence, int* length)
+        {
+            static const struct {
+                const char* token;
+                int precedence;
+                int op;
+            } operators[] = {
+                {"||", 1, CC_OR}, {"&&", 2, CC_AND}, {"==", 6, CC_EQ}, {"!=", 6, CC_NE}, {"<=", 7, CC_LE}, {">=", 7, CC_GE}, {"|", 3, CC_BOR},
+                {"^", 4, CC_BXOR}, {"&", 5, CC_BAND}, {"<", 7, CC_LT}, {">", 7, CC_GT}, {"+", 8, CC_ADD}, {"-", 8, CC_SUB},
+            };
+            skipSpace();
+            for (auto& op : operators) {
+                *length = (int)strlen(op.token);
+                if (0 == strncmp(ptr, op.token, *length)) {
+                    *precedence = op.precedence;
+                    return op.op;
+                }
+            }
+            return -1;
+        }
+
+        void compileBinary(int minPrecedence)
+        {
+            compileUnary();
+            int precedence, length, op;
+            while (!error && 0 <= (op = peekBinary(&precedence, &length)) && minPrecedence <= precedence) {
+                ptr += length;
+                compileBinary(precedence + 1);
+                code->push_back(op);
+            }
+        }
+
+        void compileUnary()
+        {
+            int op = match("!") ? CC_NOT : match("-") ? CC_NEG : match("~") ? CC_INV : -1;
+            if (op < 0) {
+                compilePrimary();
+            } else {
+                compileUnary();
+                code->push_back(op);
+            }
+        }
+
+        void compilePrimary()
+        {
+            if (match("(")) {
+                compileBinary(1);
+                if (!match(")")) error = true;
+                return;
+            }
+            skipSpace();
+            if (*ptr == '$' || isdigit((unsigned char)*ptr)) {
+                int base = 10;
+                if (*ptr == '$') {
+                    base = 16;
+                    ptr++;
+                } else if (ptr[0] == '0' && (ptr[1] == 'x' || ptr[1] == 'X')) {
+                    base = 16;
+                    ptr += 2;
+                }
+                // the digits must follow the prefix immediately (e.g., "$ 10" and "0x0x10" are invalid)
+                const char* digits = ptr;
+                int value = 0;
+                while (isxdigit((unsigned char)*ptr) && (16 == base || isdigit((unsigned char)*ptr))) {
+                    int digit = isdigit((unsigned char)*ptr) ? *ptr - '0' : tolower((unsigned char)*ptr) - 'a' + 10;
+                    value = value * base + digit;
+                    ptr++;
+                    if (0xFFFF < value) {
+                        error = true;
+                        return;
+                    }
+                }
+                if (ptr == digits || isalnum((unsigned char)*ptr)) error = true;
+                code->push_back(CC_NUM);
+                code->push_back((int)value);
+                return;
+            }
+            char name[8];
+            size_t length = 0;
+            while (isalnum((unsigned char)*ptr) && length < sizeof(name) - 1) name[length++] = (char)tolower((unsigned char)*ptr++);
+            name[length] = '\0';
+            if (0 == strcmp(name, "a")) {
+                code->push_back(CC_A);
+            } else if (0 == strcmp(name, "x")) {
+                code->push_back(CC_X);
+            } else if (0 == strcmp(name, "y")) {
+                code->push_back(CC_Y);
+            } else if (0 == strcmp(name, "s")) {
+                code->push_back(CC_S);
+            } else if (0 == strcmp(name, "p")) {
+                code->push_back(CC_P);
+            } else if (0 == strcmp(name, "pc")) {
+                code->push_back(CC_PC);
+            } else if (0 == strcmp(name, "hits")) {
+                code->push_back(CC_HITS);
+            } else if (0 == strcmp(name, "mem") && match("[")) {
+                compileBinary(1);
+                if (!match("]")) error = true;
+                code->push_back(CC_MEM);
+            } else {
+                error = true;
+            }
+        }
+    };
+
     class BreakPoint
     {
       public:
         unsigned short addr;
         void (*callback)(void* arg);
+        std::vector<int> condition; // compiled by ConditionCompiler (empty: always)
+        unsigned int hits;          // number of times the address was fetched
         BreakPoint(unsigned short addr, void (*callback)(void* arg))
         {
             this->addr = addr;
             this->callback = callback;
+            this->hits = 0;
         }
     };
 
@@ -72,14 +536,51 @@ class M6502
         }
     };
 
+    class WatchPoint
+    {
+      public:
+        unsigned short addrFrom;
+        unsigned short addrTo;
+        int access;
+        void (*callback)(void* arg, int access, unsigned short addr, unsigned char value);
+        WatchPoint(unsigned short addrFrom, unsigned short addrTo, int access, void (*callback)(void* arg, int access, unsigned short addr, unsigned char value))
+        {
+            this->addrFrom = addrFrom;
+            this->addrTo = addrTo;
+            this->access = access;
+            this->callback = callback;
+        }
+    };
+
+    struct Event {
+        unsigned long long clock;   // absolute clock to fire
+        unsigned int sequence;      // the events of the same clock fire in order of addition
+        void (*callback)(void* arg);
+        // the earliest event is the top of the heap
+        bool operator<(const Event& other) const { return clock != other.clock ? clock > other.clock : sequence > other.sequence; }
+    };
+
+    struct CatchUp {
+        void (*callback)(void* arg, int clocks);
+        unsigned long long clock; // absolute clock at the last call
+    };
+
     struct Callback {
-        unsigned char (*readMemory)(void* arg, unsigned short addr);
-        void (*writeMemory)(void* arg, unsigned short addr, unsigned char value);
         void (*debugMessage)(void* arg, const char* message);
+        void (*trace)(void* arg, const M6502TraceEvent* event);
         void (*consumeClock)(void* arg);
+        void (*consumeClocks)(void* arg, int clocks);
         void (*onError)(void* arg, int error);
-        std::vector<BreakPoint*> breakPoints;
-        std::vector<BreakOperand*> breakOperands;
+        std::vector<BreakPoint> breakPoints; // sorted by the address (same address: in order of addition)
+        unsigned char* breakPointMap;        // bitmap of the addresses of breakPoints
+        std::vector<BreakOperand> breakOperands; // sorted by the operand code (same code: in order of addition)
+        unsigned char breakOperandMap[32];       // bitmap of the operand codes of breakOperands
+        std::vector<WatchPoint> watchPoints;
+        unsigned char* watchPage;                // M6502_WATCH_XXX of each page (NULL: no watch point is armed)
+        unsigned char* watchMap[2];              // bitmaps of the addresses (0: read, 1: write) in the same block as watchPage
+        std::vector<Event> events;  // min-heap of the scheduled events
+        std::vector<CatchUp> catchUps;
+        unsigned int eventSequence;
         void* arg;
     } CB;
 
@@ -89,10 +590,97 @@ class M6502
         char opp[32];
     } DD;
 
+    M6502TraceEvent TR;
+    int traceClocks; // clockConsumed at the start of the traced operation
+
+    struct PredecodeEntry {
+        unsigned char length; // 0: not decoded yet
+        unsigned char code[3];
+    };
+
+    struct BlockOperation {
+        void (*operand)(M6502T*);
+        int (*fusion)(M6502T*, BlockOperation*); // executes this and the next operation at once (returns the number of executed operations)
+        unsigned char code[3];
+        unsigned char length;
+    };
+
+    struct Block {
+        unsigned short addr; // start address
+        int count;           // number of operations
+        int cycles;          // sum of the base cycles
+        int maxCycles;       // sum of the cycles including the penalty cycles
+        Block* next[2];      // chained successor blocks
+        int executed;        // number of executions (M6502_ENGINE_JIT)
+        int (*jit)(M6502T*); // translated code of the leading operations (returns the consumed clocks)
+        int jitCount;        // number of the translated operations
+        bool jitDecimal;     // translated operations contain ADC or SBC (not translated in the decimal mode)
+        bool jitFailed;      // the first operation cannot be translated
+        BlockOperation operations[M6502_BLOCK_MAX_OPERATIONS];
+    };
+
+    struct Predecode {
+        unsigned int area[8];         // bitmap of the pages that can be predecoded
+        PredecodeEntry* pages[256];   // allocated when an operation of the page is executed at first
+        const unsigned char* replay;  // predecoded bytes of the current operation
+        PredecodeEntry* recordEntry;  // entry to store the current operation
+        unsigned short recordAddr;    // address of the current operation
+        PredecodeEntry record;        // fetched bytes of the current operation
+        Block** blockPages[256];      // basic blocks (M6502_ENGINE_BLOCK)
+        int blockCount;               // number of basic blocks
+        bool blockInvalidated;        // basic blocks will be discarded at the next block boundary
+        unsigned char* jitBuffer;     // executable memory (M6502_ENGINE_JIT)
+        size_t jitUsed;               // used size of the executable memory
+    } * PD;
+
+    struct IdleLoop {
+        unsigned char* stable;  // bitmap of the stable addresses
+        bool active;            // an iteration of a candidate loop is being observed
+        bool dirty;             // the iteration wrote the memory or read an unstable address
+        unsigned short pc;      // start address of the candidate loop
+        unsigned char a, x, y, p, s;
+        unsigned int tickCount; // R.tickCount at the start of the iteration
+        int clocks;             // clockConsumed at the start of the iteration
+    } IL;
+
     int clockConsumed;
-    void (*operands[256])(M6502*);
+    unsigned long long clockBase; // absolute clock at the start of the current execute
+    bool nmiExecuted;
+    int clockNotified;          // clockConsumed at the last call of CB.consumeClocks
+    unsigned char* clockSync;   // bitmap of the addresses that require CB.consumeClocks or CB.catchUps before the access
+    unsigned char* catchUpIndex; // index + 1 of CB.catchUps for each address (0: none)
+    int engine;
+    int lazyResult;             // result of the last operation that updates N and Z (-1: R.p is up to date)
+    unsigned char* lowMemory;   // host memory of $0000-$01FF (M6502_FEATURE_LOW_MEMORY)
+
+    // the operand table is shared by all of the instances (index 0: with BCD, 1: without BCD)
+    struct OperandTable {
+        void (*operands[256])(M6502T*);
+    };
+    static const OperandTable operandTables[2];
+
+    // N and Z of every result (shared by all of the instances)
+    struct FlagTable {
+        unsigned char nz[256];
+    };
+    static const FlagTable flagTable;
     int mode;
-    inline bool isSupportBCD() { return this->mode == M6502_MODE_NORMAL; }
+    inline int getMode() { return Mode == M6502_MODE_RUNTIME ? this->mode : Mode; }
+    inline bool isSupportBCD() { return getMode() == M6502_MODE_NORMAL; }
+    inline bool isDebug() { return (Features & M6502_FEATURE_DEBUG) && CB.debugMessage; }
+    inline bool isTrace() { return (Features & M6502_FEATURE_TRACE) && CB.trace; }
+    inline bool isSupportBreak() { return (Features & M6502_FEATURE_BREAK) != 0; }
+    inline bool isPredecode() { return (Features & M6502_FEATURE_PREDECODE) && PD; }
+    inline bool isLazyFlags() { return (Features & M6502_FEATURE_LAZY_FLAGS) != 0; }
+    inline bool isClockSync() { return (Features & M6502_FEATURE_CLOCK_SYNC) && clockSync; }
+
+    inline void raiseError(int error)
+    {
+        if ((Features & M6502_FEATURE_ERROR) && CB.onError) {
+            syncStatus();
+            CB.onError(CB.arg, error);
+        }
+    }
 
   public:
     /**
@@ -111,293 +699,1940 @@ class M6502
         unsigned char interrupt;
     } R;
 
-    /**
-     * Constructor
-     * - [i] mode: emulation mode (Specify M6502_MODE_XXX)
-     * - [i] readMemory: callback function pointer of read memory
-     * - [i] writeMemory: callback function pointer of write memory
-     * - [i] arg: argument when calling the callback functions
-     */
-    M6502(int mode, unsigned char (*readMemory)(void* arg, unsigned short addr), void (*writeMemory)(void* arg, unsigned short addr, unsigned char value), void* arg)
+    /**
+     * Memory bus
+     */
+    Bus bus;
+
+    /**
+     * Constructor (the emulation mode is specified by the template argument)
+     * - [i] bus: memory bus
+     * - [i] arg: argument when calling the callback functions
+     */
+    M6502T(const Bus& bus, void* arg = NULL) : M6502T(Mode == M6502_MODE_RUNTIME ? M6502_MODE_NORMAL : Mode, bus, arg)
+    {
+    }
+
+    /**
+     * Constructor
+     * - [i] mode: emulation mode (Specify M6502_MODE_XXX, ignored if the template argument is not M6502_MODE_RUNTIME)
+     * - [i] bus: memory bus
+     * - [i] arg: argument when calling the callback functions
+     */
+    M6502T(int mode, const Bus& bus, void* arg = NULL) : bus(bus)
+    {
+        this->mode = Mode == M6502_MODE_RUNTIME ? mode : Mode;
+        memset(&R, 0, sizeof(R));
+        CB.debugMessage = NULL;
+        CB.trace = NULL;
+        CB.consumeClock = NULL;
+        CB.consumeClocks = NULL;
+        CB.onError = NULL;
+        CB.breakPoints.clear();
+        CB.breakPointMap = NULL;
+        CB.breakOperands.clear();
+        memset(CB.breakOperandMap, 0, sizeof(CB.breakOperandMap));
+        CB.watchPage = NULL;
+        CB.watchMap[0] = NULL;
+        CB.watchMap[1] = NULL;
+        CB.eventSequence = 0;
+        CB.arg = arg;
+        engine = M6502_ENGINE_TABLE;
+        PD = NULL;
+        lowMemory = NULL;
+        clockSync = NULL;
+        catchUpIndex = NULL;
+        clockConsumed = 0;
+        clockNotified = 0;
+        clockBase = 0;
+        nmiExecuted = false;
+        memset(&IL, 0, sizeof(IL));
+        reset();
+    }
+
+    ~M6502T()
+    {
+        if (IL.stable) delete[] IL.stable;
+        if (clockSync) delete[] clockSync;
+        if (catchUpIndex) delete[] catchUpIndex;
+        removeAllBreakPoints();
+        if (CB.breakPointMap) delete[] CB.breakPointMap;
+        if (CB.watchPage) delete[] CB.watchPage;
+        removeAllBreakOperands();
+        if (PD) {
+            flushPredecode();
+            flushBlocks();
+            for (int i = 0; i < 256; i++) {
+                if (PD->blockPages[i]) delete[] PD->blockPages[i];
+            }
+#ifdef M6502_JIT_SUPPORTED
+            if (PD->jitBuffer) munmap(PD->jitBuffer, M6502_JIT_BUFFER_SIZE);
+#endif
+            delete PD;
+        }
+    }
+
+    /**
+     * Execute
+     * - [i] clocks: number of clocks expected to execute CPU
+     * - [i] executeUntilNMI: execute CPU until NMI (clocks will be ignored)
+     * - return: number of clocks actually executed
+     */
+    int execute(int clocks, bool executeUntilNMI = false)
+    {
+        flushClocks(); // the clocks consumed outside of execute (e.g., reset)
+        this->clockBase += this->clockConsumed;
+        this->clockConsumed = 0;
+        this->clockNotified = 0;
+        IL.active = false;
+        if (CB.events.empty()) {
+            runEngine(clocks, executeUntilNMI);
+        } else {
+            // run the engine until the next event
+            do {
+                if (dispatchEvents() && checkInterrupt()) executeUntilNMI = false;
+                int limit = clocks;
+                bool untilNMI = executeUntilNMI;
+                if (!CB.events.empty()) {
+                    long long next = (long long)(CB.events.front().clock - this->clockBase);
+                    if (next < limit || (executeUntilNMI && next < 0x7FFFFFFF)) {
+                        limit = (int)next;
+                        untilNMI = false;
+                    }
+                }
+                nmiExecuted = false;
+                runEngine(limit, untilNMI);
+                if (nmiExecuted) executeUntilNMI = false;
+            } while (this->clockConsumed < clocks || executeUntilNMI);
+        }
+        flushClocks();
+        if (isClockSync()) {
+            for (size_t i = 0; i < CB.catchUps.size(); i++) catchUp(&CB.catchUps[i]);
+        }
+        syncStatus();
+        return this->clockConsumed;
+    }
+
+    /**
+     * Get the number of clocks consumed since the construction
+     * - return: absolute clock
+     */
+    unsigned long long getClock() { return this->clockBase + this->clockConsumed; }
+
+    /**
+     * Add an event that is called at the boundary of the operations when the absolute clock reached
+     * execute stops the execution at the clock of the next event, so the callback can call IRQ or NMI at the exact timing.
+     * The callback can add the next event (e.g., addEvent(cpu->getClock() + 29780, callback) for every frame).
+     * - [i] clock: absolute clock (see getClock)
+     * - [i] callback: event callback function pointer
+     */
+    void addEvent(unsigned long long clock, void (*callback)(void* arg))
+    {
+        Event event;
+        event.clock = clock;
+        event.sequence = CB.eventSequence++;
+        event.callback = callback;
+        CB.events.push_back(event);
+        std::push_heap(CB.events.begin(), CB.events.end());
+    }
+
+    /**
+     * Remove the events
+     * - [i] callback: event callback function pointer to remove
+     */
+    void removeEvent(void (*callback)(void* arg))
+    {
+        auto end = std::remove_if(CB.events.begin(), CB.events.end(), [callback](const Event& event) { return event.callback == callback; });
+        CB.events.erase(end, CB.events.end());
+        std::make_heap(CB.events.begin(), CB.events.end());
+    }
+
+    /**
+     * Remove the all of events
+     */
+    void removeAllEvents()
+    {
+        CB.events.clear();
+    }
+
+    /**
+     * Bind a host memory to the zero page and the stack (requires M6502_FEATURE_LOW_MEMORY)
+     * The accesses to $0000-$01FF will not call the memory bus (the clock cycles are the same).
+     * - [i] memory: host memory (512 bytes) or NULL (use the memory bus)
+     */
+    void setLowMemory(unsigned char* memory)
+    {
+        static_assert(Features & M6502_FEATURE_LOW_MEMORY, "M6502_FEATURE_LOW_MEMORY is not specified");
+        this->lowMemory = memory;
+    }
+
+    /**
+     * Add an area that is stable until the next interrupt while the CPU does not write (requires M6502_FEATURE_IDLE_SKIP)
+     * An idle loop that does not write and reads only the stable area or the predecode area is fast-forwarded to the end of the clocks.
+     * Please specify I/O only if reading it has no side effect and its value does not change until the next interrupt.
+     * - [i] addrFrom: start address
+     * - [i] addrTo: end address
+     */
+    void addStableArea(unsigned short addrFrom, unsigned short addrTo)
+    {
+        static_assert(Features & M6502_FEATURE_IDLE_SKIP, "M6502_FEATURE_IDLE_SKIP is not specified");
+        if (!IL.stable) {
+            IL.stable = new unsigned char[0x2000];
+            memset(IL.stable, 0, 0x2000);
+        }
+        for (int addr = addrFrom; addr <= addrTo; addr++) {
+            IL.stable[addr >> 3] |= 1 << (addr & 7);
+        }
+    }
+
+    /**
+     * Set the execution engine
+     * - [i] engine: M6502_ENGINE_XXX
+     */
+    void setEngine(int engine) { this->engine = engine; }
+
+    /**
+     * Execute an interrupt request (IRQ)
+     */
+    void IRQ() { R.interrupt |= 0b01; }
+
+    /**
+     * Execute a non-maskable interrupt (NMI)
+     */
+    void NMI() { R.interrupt |= 0b11; }
+
+    /**
+     * Execute a reset interrupt
+     */
+    void reset()
+    {
+        lazyResult = -1;
+        R.tickCount = 0;
+        R.s = 0;
+        consumeClock();
+        updateStatusI(true, true);
+        updateStatusB(false, true);
+        push(0);
+        R.pc = readMemory16(0xFFFC);
+        consumeClock();
+        consumeClock();
+        consumeClock();
+    }
+
+    /**
+     * Explicit consume of the CPU clock(s)
+     * - return: number of CPU clocks to consume
+     */
+    void consumeClock(int clocks)
+    {
+        if (!isClockCallback()) {
+            this->clockConsumed += clocks;
+            return;
+        }
+        for (int i = 0; i < clocks; i++) {
+            consumeClock();
+        }
+    }
+
+    /**
+     * Stall the CPU (e.g., DMA)
+     * The clocks are consumed at once if the clock callback is not set, and the batched clock callback is called once.
+     * - [i] clocks: number of CPU clocks to stall
+     * - [i] alignment: add a clock if the stall starts at an odd clock (see getClock)
+     * - return: number of CPU clocks actually stalled
+     */
+    int stall(int clocks, bool alignment = false)
+    {
+        if (alignment && (getClock() & 1)) clocks++;
+        consumeClock(clocks);
+        flushClocks();
+        return clocks;
+    }
+
+    /**
+     * Set the callback function that called when consumed a CPU clock (requires M6502_FEATURE_CLOCK)
+     * - [i] callback: function pointer
+     */
+    void setConsumeClock(void (*callback)(void* arg) = NULL)
+    {
+        static_assert(Features & M6502_FEATURE_CLOCK, "M6502_FEATURE_CLOCK is not specified");
+        CB.consumeClock = callback;
+    }
+
+    /**
+     * Set the callback function that called with the number of clocks consumed since the last call (requires M6502_FEATURE_CLOCK)
+     * It is called at the end of every operation, at the start and the end of execute and before accessing the clock sync area.
+     * It is not called while the callback of setConsumeClock is set.
+     * - [i] callback: function pointer
+     */
+    void setConsumeClocks(void (*callback)(void* arg, int clocks) = NULL)
+    {
+        static_assert(Features & M6502_FEATURE_CLOCK, "M6502_FEATURE_CLOCK is not specified");
+        CB.consumeClocks = callback;
+    }
+
+    /**
+     * Add an area that requires the callback of setConsumeClocks before every access (e.g., I/O of the timers) (requires M6502_FEATURE_CLOCK_SYNC)
+     * - [i] addrFrom: start address
+     * - [i] addrTo: end address
+     */
+    void addClockSyncArea(unsigned short addrFrom, unsigned short addrTo)
+    {
+        static_assert(Features & M6502_FEATURE_CLOCK_SYNC, "M6502_FEATURE_CLOCK_SYNC is not specified");
+        if (!clockSync) {
+            clockSync = new unsigned char[0x2000];
+            memset(clockSync, 0, 0x2000);
+        }
+        for (int addr = addrFrom; addr <= addrTo; addr++) {
+            clockSync[addr >> 3] |= 1 << (addr & 7);
+        }
+    }
+
+    /**
+     * Add a catch-up handler of the peripheral mapped to an area (e.g., $2000-$2007 of the PPU) (requires M6502_FEATURE_CLOCK_SYNC)
+     * The callback is called with the number of clocks consumed since the last call just before the access to the area and at the end of execute.
+     * The same callback can be added to multiple areas (up to 255 callbacks).
+     * - [i] addrFrom: start address
+     * - [i] addrTo: end address
+     * - [i] callback: catch-up callback function pointer
+     * - return: false if 255 callbacks have already been added (the area is not added)
+     */
+    bool addCatchUp(unsigned short addrFrom, unsigned short addrTo, void (*callback)(void* arg, int clocks))
+    {
+        static_assert(Features & M6502_FEATURE_CLOCK_SYNC, "M6502_FEATURE_CLOCK_SYNC is not specified");
+        size_t index = 0;
+        while (index < CB.catchUps.size() && CB.catchUps[index].callback != callback) index++;
+        if (index == CB.catchUps.size()) {
+            if (255 <= index) return false; // catchUpIndex holds index + 1 in a byte
+            CatchUp catchUp;
+            catchUp.callback = callback;
+            catchUp.clock = getClock();
+            CB.catchUps.push_back(catchUp);
+        }
+        if (!catchUpIndex) {
+            catchUpIndex = new unsigned char[0x10000];
+            memset(catchUpIndex, 0, 0x10000);
+        }
+        for (int addr = addrFrom; addr <= addrTo; addr++) {
+            catchUpIndex[addr] = (unsigned char)(index + 1);
+        }
+        addClockSyncArea(addrFrom, addrTo);
+        return true;
+    }
+
+    /**
+     * Set the callback function that called when executed an operand (requires M6502_FEATURE_DEBUG)
+     * - [i] callback: function pointer
+     */
+    void setDebugMessage(void (*callback)(void* arg, const char* message) = NULL)
+    {
+        static_assert(Features & M6502_FEATURE_DEBUG, "M6502_FEATURE_DEBUG is not specified");
+        CB.debugMessage = callback;
+    }
+
+    /**
+     * Set the callback function that called with the trace record when executed an operand (requires M6502_FEATURE_TRACE)
+     * The record is not formatted, so it is faster than setDebugMessage.
+     * - [i] callback: function pointer
+     */
+    void setTrace(void (*callback)(void* arg, const M6502TraceEvent* event) = NULL)
+    {
+        static_assert(Features & M6502_FEATURE_TRACE, "M6502_FEATURE_TRACE is not specified");
+        CB.trace = callback;
+    }
+
+    /**
+     * Set the callback function that called when detected an error (requires M6502_FEATURE_ERROR)
+     * - [i] callback: function pointer
+     */
+    void setOnError(void (*callback)(void* arg, int errorCode) = NULL)
+    {
+        static_assert(Features & M6502_FEATURE_ERROR, "M6502_FEATURE_ERROR is not specified");
+        CB.onError = callback;
+    }
+
+    /**
+     * Add a break point (requires M6502_FEATURE_BREAK)
+     * - [i] addr: address
+     * - [i] callback: detection callback function pointer
+     */
+    void addBreakPoint(unsigned short addr, void (*callback)(void*))
+    {
+        static_assert(Features & M6502_FEATURE_BREAK, "M6502_FEATURE_BREAK is not specified");
+        if (!CB.breakPointMap) {
+            CB.breakPointMap = new unsigned char[0x2000];
+            memset(CB.breakPointMap, 0, 0x2000);
+        }
+        auto it = std::upper_bound(CB.breakPoints.begin(), CB.breakPoints.end(), addr, [](unsigned short addr, const BreakPoint& bp) { return addr < bp.addr; });
+        CB.breakPoints.insert(it, BreakPoint(addr, callback));
+        CB.breakPointMap[addr >> 3] |= 1 << (addr & 7);
+    }
+
+    /**
+     * Add a conditional break point (requires M6502_FEATURE_BREAK)
+     * The condition is compiled at adding, and evaluated only when PC is the address.
+     * - Values: A, X, Y, S, P, PC, hits (number of times PC was the address), mem[address], $hex, 0xhex and decimal
+     * - mem[address] reads the low memory and the peek of the Bus (e.g. the mapped pages of M6502PagedBus) without side effects, and the others are 0
+     * - Operators: ! - ~ + - < <= > >= == != & ^ | && || and parentheses (same precedence as C)
+     * - [i] addr: address
+     * - [i] callback: detection callback function pointer
+     * - [i] condition: condition (e.g., "A == $40 && X < 3", "mem[$00FE] & $80", "hits > 100")
+     * - return: false if the condition is invalid or NULL
+     */
+    bool addBreakPoint(unsigned short addr, void (*callback)(void*), const char* condition)
+    {
+        static_assert(Features & M6502_FEATURE_BREAK, "M6502_FEATURE_BREAK is not specified");
+        if (!condition) return false;
+        BreakPoint bp(addr, callback);
+        ConditionCompiler compiler(condition, &bp.condition);
+        if (!compiler.compile()) return false;
+        addBreakPoint(addr, callback);
+        CB.breakPoints[findBreakPoint(addr, callback)].condition.swap(bp.condition);
+        return true;
+    }
+
+    /**
+     * Remove a break point
+     * - [i] callback: detection callback function pointer to remove
+     */
+    void removeBreakPoint(void (*callback)(void*))
+    {
+        for (size_t i = 0; i < CB.breakPoints.size(); i++) {
+            if (CB.breakPoints[i].callback == callback) {
+                unsigned short addr = CB.breakPoints[i].addr;
+                CB.breakPoints.erase(CB.breakPoints.begin() + i);
+                if (findBreakPoint(addr) == CB.breakPoints.size()) CB.breakPointMap[addr >> 3] &= ~(1 << (addr & 7));
+                return;
+            }
+        }
+    }
+
+    /**
+     * Remove the all of break points
+     */
+    void removeAllBreakPoints()
+    {
+        CB.breakPoints.clear();
+        if (CB.breakPointMap) memset(CB.breakPointMap, 0, 0x2000);
+    }
+
+    /**
+     * Add a break operand (requires M6502_FEATURE_BREAK)
+     * - [i] operand: operand code
+     * - [i] callback: detection callback function pointer
+     */
+    void addBreakOperand(unsigned char operand, void (*callback)(void*))
+    {
+        static_assert(Features & M6502_FEATURE_BREAK, "M6502_FEATURE_BREAK is not specified");
+        auto it = std::upper_bound(CB.breakOperands.begin(), CB.breakOperands.end(), operand, [](unsigned char operand, const BreakOperand& bo) { return operand < bo.operand; });
+        CB.breakOperands.insert(it, BreakOperand(operand, callback));
+        CB.breakOperandMap[operand >> 3] |= 1 << (operand & 7);
+    }
+
+    /**
+     * Remove a break operand
+     * - [i] callback: detection callback function pointer to remove
+     */
+    void removeBreakOperand(void (*callback)(void*))
+    {
+        for (size_t i = 0; i < CB.breakOperands.size(); i++) {
+            if (CB.breakOperands[i].callback == callback) {
+                unsigned char operand = CB.breakOperands[i].operand;
+                CB.breakOperands.erase(CB.breakOperands.begin() + i);
+                if (findBreakOperand(operand) == CB.breakOperands.size()) CB.breakOperandMap[operand >> 3] &= ~(1 << (operand & 7));
+                return;
+            }
+        }
+    }
+
+    /**
+     * Remove the all of break operands
+     */
+    void removeAllBreakOperands()
+    {
+        CB.breakOperands.clear();
+        memset(CB.breakOperandMap, 0, sizeof(CB.breakOperandMap));
+    }
+
+    /**
+     * Add a watch point (requires M6502_FEATURE_BREAK)
+     * The callback is called after reading or before writing the memory in the area (the predecoded operation bytes are not read).
+     * - [i] addrFrom: start address
+     * - [i] addrTo: end address
+     * - [i] access: M6502_WATCH_READ, M6502_WATCH_WRITE or both
+     * - [i] callback: detection callback function pointer
+     */
+    void addWatchPoint(unsigned short addrFrom, unsigned short addrTo, int access, void (*callback)(void* arg, int access, unsigned short addr, unsigned char value))
+    {
+        static_assert(Features & M6502_FEATURE_BREAK, "M6502_FEATURE_BREAK is not specified");
+        CB.watchPoints.push_back(WatchPoint(addrFrom, addrTo, access, callback));
+        updateWatchMap();
+    }
+
+    /**
+     * Remove a watch point
+     * - [i] callback: detection callback function pointer to remove
+     */
+    void removeWatchPoint(void (*callback)(void* arg, int access, unsigned short addr, unsigned char value))
+    {
+        for (size_t i = 0; i < CB.watchPoints.size(); i++) {
+            if (CB.watchPoints[i].callback == callback) {
+                CB.watchPoints.erase(CB.watchPoints.begin() + i);
+                updateWatchMap();
+                return;
+            }
+        }
+    }
+
+    /**
+     * Remove the all of watch points
+     */
+    void removeAllWatchPoints()
+    {
+        CB.watchPoints.clear();
+        updateWatchMap();
+    }
+
+    /**
+     * Add an area where the operations are predecoded (requires M6502_FEATURE_PREDECODE)
+     * The operations in this area will be executed without reading the operation bytes from the memory bus.
+     * Please specify only ROM/RAM that has no side effect at reading (do not specify I/O).
+     * - [i] addrFrom: start address (the area is managed in a unit of page: 256 bytes)
+     * - [i] addrTo: end address
+     */
+    void addPredecodeArea(unsigned short addrFrom, unsigned short addrTo)
+    {
+        static_assert(Features & M6502_FEATURE_PREDECODE, "M6502_FEATURE_PREDECODE is not specified");
+        if (!PD) {
+            PD = new Predecode();
+            memset(PD, 0, sizeof(Predecode));
+        }
+        for (int page = addrFrom >> 8; page <= addrTo >> 8; page++) {
+            PD->area[page >> 5] |= 1U << (page & 31);
+        }
+    }
+
+    /**
+     * Discard the all of predecoded operations
+     * Please call this when the memory of the predecode area was changed without the CPU (e.g. bank switching).
+     */
+    void flushPredecode()
+    {
+        if (!PD) return;
+        for (int i = 0; i < 256; i++) {
+            if (PD->pages[i]) {
+                delete[] PD->pages[i];
+                PD->pages[i] = NULL;
+            }
+        }
+        PD->replay = NULL;
+        PD->recordEntry = NULL;
+        if (PD->blockCount) PD->blockInvalidated = true;
+    }
+
+  private:
+    inline void runEngine(int clocks, bool executeUntilNMI)
+    {
+        switch (engine) {
+            case M6502_ENGINE_SWITCH: run<M6502_ENGINE_SWITCH>(clocks, executeUntilNMI); break;
+            case M6502_ENGINE_BLOCK:
+            case M6502_ENGINE_JIT:
+                if (Features & M6502_FEATURE_PREDECODE) {
+                    runBlocks(clocks, executeUntilNMI, engine == M6502_ENGINE_JIT);
+                } else {
+                    run<M6502_ENGINE_TABLE>(clocks, executeUntilNMI);
+                }
+                break;
+            default: run<M6502_ENGINE_TABLE>(clocks, executeUntilNMI);
+        }
+    }
+
+    // returns true if any event was fired
+    inline bool dispatchEvents()
+    {
+        bool fired = false;
+        while (!CB.events.empty() && CB.events.front().clock <= getClock()) {
+            void (*callback)(void* arg) = CB.events.front().callback;
+            std::pop_heap(CB.events.begin(), CB.events.end());
+            CB.events.pop_back();
+            flushClocks();
+            syncStatus();
+            callback(CB.arg);
+            fired = true;
+        }
+        if (fired) IL.active = false; // the callback may change the memory or the registers observed by the idle loop
+        return fired;
+    }
+
+    template <int Engine>
+    inline void run(int clocks, bool executeUntilNMI)
+    {
+        while (this->clockConsumed < clocks || executeUntilNMI) {
+            unsigned short pc = R.pc;
+            if (step<Engine>()) executeUntilNMI = false;
+            if (isIdleSkip() && !executeUntilNMI) checkIdleLoop(pc, clocks);
+        }
+    }
+
+    inline bool isIdleSkip() { return (Features & M6502_FEATURE_IDLE_SKIP) != 0; }
+
+    inline bool isStableAddress(unsigned short addr)
+    {
+        if (IL.stable && (IL.stable[addr >> 3] & (1 << (addr & 7)))) return true;
+        return isPredecode() && isPredecodeArea(addr);
+    }
+
+    // observe the iterations of the loop that jumps backward from pc, and fast-forward it if it is idle
+    inline void checkIdleLoop(unsigned short pc, int clocks)
+    {
+        if (pc < R.pc) return; // not a backward jump
+        syncStatus();
+        if (IL.active && !IL.dirty && IL.pc == R.pc && IL.a == R.a && IL.x == R.x && IL.y == R.y && IL.p == R.p && IL.s == R.s && !R.interrupt) {
+            // the next iterations will be the same as this iteration (skip them except the last one that reaches the end of the clocks)
+            int cycles = this->clockConsumed - IL.clocks;
+            int remain = clocks - this->clockConsumed;
+            if (0 < cycles && cycles < remain && !isClockCallback() && !isClockBatch() && !isDebug() && !isTrace() && (!isSupportBreak() || (CB.breakPoints.empty() && CB.breakOperands.empty() && CB.watchPoints.empty()))) {
+                int iterations = (remain - 1) / cycles;
+                this->clockConsumed += iterations * cycles;
+                R.tickCount += iterations * (R.tickCount - IL.tickCount);
+            }
+        }
+        IL.active = true;
+        IL.dirty = false;
+        IL.pc = R.pc;
+        IL.a = R.a;
+        IL.x = R.x;
+        IL.y = R.y;
+        IL.p = R.p;
+        IL.s = R.s;
+        IL.tickCount = R.tickCount;
+        IL.clocks = this->clockConsumed;
+    }
+
+    // execute an operation (returns true if NMI was executed)
+    template <int Engine>
+    inline bool step()
+    {
+        unsigned char opcode = fetchOperand();
+        bool executed;
+        if (Engine == M6502_ENGINE_SWITCH) {
+            executed = executeOperandBySwitch(opcode);
+        } else {
+            void (*operand)(M6502T*) = operandTables[isSupportBCD() ? 0 : 1].operands[opcode];
+            if (operand) operand(this);
+            executed = operand ? true : false;
+        }
+        executedOperand(executed);
+        return checkInterrupt();
+    }
+
+    // execute the basic blocks while the clocks allow (M6502_ENGINE_BLOCK)
+    inline void runBlocks(int clocks, bool executeUntilNMI, bool jit)
+    {
+        jit = jit && isJitExecutable();
+        Block* previous = NULL;
+        while (this->clockConsumed < clocks || executeUntilNMI) {
+            if (PD && PD->blockInvalidated) {
+                flushBlocks();
+                previous = NULL;
+            }
+            Block* block = isBlockExecutable() ? findBlock(previous) : NULL;
+            unsigned short pc = R.pc;
+            if (block && (executeUntilNMI || this->clockConsumed + block->maxCycles <= clocks)) {
+                if (executeBlock(block, jit)) {
+                    previous = block;
+                } else {
+                    previous = NULL;
+                    if (checkInterrupt()) executeUntilNMI = false;
+                }
+            } else {
+                previous = NULL;
+                if (step<M6502_ENGINE_TABLE>()) executeUntilNMI = false;
+            }
+            if (isIdleSkip() && !executeUntilNMI) checkIdleLoop(pc, clocks);
+        }
+    }
+
+    inline bool isBlockExecutable()
+    {
+        if (!isPredecode() || isDebug() || isTrace()) return false;
+        return !isSupportBreak() || (CB.breakPoints.empty() && CB.breakOperands.empty());
+    }
+
+    // returns false if the block was interrupted
+    inline bool executeBlock(Block* block, bool jit)
+    {
+        int i = 0;
+#ifdef M6502_JIT_SUPPORTED
+        if (jit) {
+            if (!block->jit && !block->jitFailed && M6502_JIT_THRESHOLD <= ++block->executed) compileBlock(block);
+            // a pending interrupt is taken after the first operation (interpreted as M6502_ENGINE_BLOCK)
+            if (block->jit && !R.interrupt && !(block->jitDecimal && isSupportBCD() && getStatusD())) {
+                syncStatus();
+                int clocks = block->jit(this); // the translated code also writes back the clocks before the bus accesses
+                this->clockConsumed += clocks;
+                if (R.interrupt || PD->blockInvalidated) return false;
+                i = block->jitCount;
+            }
+        }
+#endif
+        for (; i < block->count; i++) {
+            BlockOperation* op = &block->operations[i];
+            R.tickCount++;
+            R.pc++;
+            consumeClock(); // fetch the opcode
+            if (op->fusion) {
+                i += op->fusion(this, op) - 1;
+            } else {
+                PD->replay = &op->code[1];
+                op->operand(this);
+            }
+            PD->replay = NULL;
+            flushClocks();
+            if (R.interrupt || PD->blockInvalidated) return false;
+        }
+        return true;
+    }
+
+    inline bool isJitExecutable()
+    {
+        // the translated code consumes the clocks at once
+        return !isClockCallback() && !isClockBatch() && !isClockSync();
+    }
+
+#ifdef M6502_JIT_SUPPORTED
+    // x86-64 machine code emitter (register mapping: rbx = this, r12d = A, r13d = X, r14d = Y, r15d = P)
+    class JitEmitter
+    {
+      public:
+        enum { EAX = 0, ECX = 1, EDX = 2, EBX = 3, ESI = 6, EDI = 7, RA = 12, RX = 13, RY = 14, RP = 15 };
+        unsigned char* ptr;
+        unsigned char* end;
+        JitEmitter(unsigned char* ptr, unsigned char* end) : ptr(ptr), end(end) {}
+        inline bool isOverflow() { return end < ptr; }
+        inline void u8(int value)
+        {
+            if (ptr < end) *ptr = (unsigned char)value;
+            ptr++;
+        }
+        inline void u16(int value) { u8(value), u8(value >> 8); }
+        inline void u32(int value) { u16(value), u16(value >> 16); }
+        inline void rex(bool w, int reg, int rm, bool byteReg = false)
+        {
+            int rex = 0x40 | (w ? 8 : 0) | (reg & 8 ? 4 : 0) | (rm & 8 ? 1 : 0);
+            if (rex != 0x40 || (byteReg && 4 <= (reg & 15) && (reg & 15) < 8)) u8(rex);
+        }
+        inline void modrm(int mod, int reg, int rm) { u8((mod << 6) | ((reg & 7) << 3) | (rm & 7)); }
+        inline void rr(int opcode, int src, int dst) { rex(false, src, dst), u8(opcode), modrm(3, src, dst); }    // op dst, src
+        inline void ri(int digit, int dst, int imm) { rex(false, 0, dst), u8(0x81), modrm(3, digit, dst), u32(imm); } // op dst, imm
+        inline void mov(int dst, int src) { rr(0x89, src, dst); }
+        inline void movi(int dst, int imm) { rex(false, 0, dst), u8(0xB8 | (dst & 7)), u32(imm); }
+        inline void add(int dst, int src) { rr(0x01, src, dst); }
+        inline void or_(int dst, int src) { rr(0x09, src, dst); }
+        inline void and_(int dst, int src) { rr(0x21, src, dst); }
+        inline void sub(int dst, int src) { rr(0x29, src, dst); }
+        inline void xor_(int dst, int src) { rr(0x31, src, dst); }
+        inline void test(int dst, int src) { rr(0x85, src, dst); }
+        inline void addi(int dst, int imm) { ri(0, dst, imm); }
+        inline void ori(int dst, int imm) { ri(1, dst, imm); }
+        inline void andi(int dst, int imm) { ri(4, dst, imm); }
+        inline void xori(int dst, int imm) { ri(6, dst, imm); }
+        inline void shl(int dst, int n) { rex(false, 0, dst), u8(0xC1), modrm(3, 4, dst), u8(n); }
+        inline void shr(int dst, int n) { rex(false, 0, dst), u8(0xC1), modrm(3, 5, dst), u8(n); }
+        inline void not_(int dst) { rex(false, 0, dst), u8(0xF7), modrm(3, 2, dst); }
+        inline void setcc(int cc, int dst) { u8(0x0F), u8(0x90 | cc), modrm(3, 0, dst); } // dst: EAX, ECX or EDX
+        inline void movzx8(int dst, int src) { rex(false, dst, src), u8(0x0F), u8(0xB6), modrm(3, dst, src); }
+        inline void load8(int dst, int disp) { rex(false, dst, EBX), u8(0x0F), u8(0xB6), modrm(2, dst, EBX), u32(disp); }
+        inline void store8(int disp, int src) { rex(false, src, EBX, true), u8(0x88), modrm(2, src, EBX), u32(disp); }
+        inline void store16i(int disp, int imm) { u8(0x66), u8(0xC7), modrm(2, 0, EBX), u32(disp), u16(imm); }
+        inline void store16(int disp, int src) { u8(0x66), rex(false, src, EBX), u8(0x89), modrm(2, src, EBX), u32(disp); }
+        inline void add32(int disp, int src) { rex(false, src, EBX), u8(0x01), modrm(2, src, EBX), u32(disp); }
+        inline void add32i(int disp, int imm) { u8(0x81), modrm(2, 0, EBX), u32(disp), u32(imm); }
+        inline void push(int reg) { rex(false, 0, reg), u8(0x50 | (reg & 7)); }
+        inline void pop(int reg) { rex(false, 0, reg), u8(0x58 | (reg & 7)); }
+        inline void call(const void* func)
+        {
+            u8(0x48), u8(0xB8); // mov rax, imm64
+            unsigned long long addr = (unsigned long long)func;
+            u32((int)addr), u32((int)(addr >> 32));
+            u8(0xFF), u8(0xD0); // call rax
+        }
+        inline unsigned char* jnz() { return u8(0x0F), u8(0x85), u32(0), ptr - 4; }
+        inline unsigned char* jmp() { return u8(0xE9), u32(0), ptr - 4; }
+        inline void patch(unsigned char* rel, unsigned char* target)
+        {
+            if (end < rel + 4) return;
+            int value = (int)(target - (rel + 4));
+            for (int i = 0; i < 4; i++) rel[i] = (unsigned char)(value >> (i * 8));
+        }
+        // update N and Z of P by the value of reg (EDX is used as a work register)
+        inline void nz(int reg)
+        {
+            andi(RP, 0x7D);
+            mov(EDX, reg);
+            andi(EDX, 0x80);
+            or_(RP, EDX);
+            test(reg, reg);
+            setcc(0x4, EDX); // setz dl
+            movzx8(EDX, EDX);
+            add(EDX, EDX);
+            or_(RP, EDX);
+        }
+    };
+
+    // bus access from the translated code (bit 8 of the result: stop the translated code)
+    static unsigned int jitRead(M6502T* cpu, unsigned int addr)
+    {
+        unsigned int result = cpu->readBus((unsigned short)addr);
+        return result | (cpu->R.interrupt || cpu->PD->blockInvalidated ? 0x100 : 0);
+    }
+
+    static unsigned int jitWrite(M6502T* cpu, unsigned int addr, unsigned int value)
+    {
+        cpu->writeBus((unsigned short)addr, (unsigned char)value);
+        return cpu->R.interrupt || cpu->PD->blockInvalidated ? 1 : 0;
+    }
+
+    inline int offsetOf(void* member) { return (int)((char*)member - (char*)this); }
+
+    // clocks and ticks of the translated code (counted from the start of the block)
+    struct JitProgress {
+        int clocks;        // clocks consumed before the current operation
+        int ticks;         // R.tickCount of the current operation
+        int writtenClocks; // clocks written back to clockConsumed
+        int writtenTicks;  // ticks written back to R.tickCount
+    };
+
+    // returns the register of the load, store, compare and transfer operations (or -1)
+    static inline int getJitRegister(unsigned char opcode)
+    {
+        switch (opcode) {
+            case 0xA9: case 0xA5: case 0xAD: case 0x85: case 0x8D: // LDA, STA
+            case 0xC9: case 0xC5: case 0xCD:                       // CMP
+                return JitEmitter::RA;
+            case 0xA2: case 0xA6: case 0xAE: case 0x86: case 0x8E: // LDX, STX
+            case 0xE0: case 0xE4: case 0xEC:                       // CPX
+                return JitEmitter::RX;
+            case 0xA0: case 0xA4: case 0xAC: case 0x84: case 0x8C: // LDY, STY
+            case 0xC0: case 0xC4: case 0xCC:                       // CPY
+                return JitEmitter::RY;
+            default: return -1;
+        }
+    }
+
+    // returns true if the operation is translatable (and emits it)
+    inline bool emitOperation(JitEmitter& e, const BlockOperation* op, unsigned short next, unsigned char** stop, JitProgress* progress)
+    {
+        unsigned char opcode = op->code[0];
+        unsigned short addr = op->code[1] | (op->code[2] << 8);
+        *stop = NULL;
+        // addressing mode of the operand: 0 = implied, 1 = immediate, 2 = zero page, 3 = absolute
+        int mode = 0;
+        switch (opcode) {
+            case 0xA9: case 0xA2: case 0xA0: case 0x29: case 0x09: case 0x49: case 0x69: case 0xE9: case 0xC9: case 0xE0: case 0xC0:
+                mode = 1;
+                break;
+            case 0xA5: case 0xA6: case 0xA4: case 0x85: case 0x86: case 0x84: case 0x25: case 0x05: case 0x45: case 0x65:
+            case 0xE5: case 0xC5: case 0xE4: case 0xC4: case 0x24:
+                mode = 2;
+                addr &= 0xFF;
+                break;
+            case 0xAD: case 0xAE: case 0xAC: case 0x8D: case 0x8E: case 0x8C: case 0x2D: case 0x0D: case 0x4D: case 0x6D:
+            case 0xED: case 0xCD: case 0xEC: case 0xCC: case 0x2C:
+                mode = 3;
+                break;
+        }
+        bool isStore = opcode == 0x85 || opcode == 0x8D || opcode == 0x86 || opcode == 0x8E || opcode == 0x84 || opcode == 0x8C;
+        switch (opcode) {
+            case 0xA9: case 0xA5: case 0xAD: case 0xA2: case 0xA6: case 0xAE: case 0xA0: case 0xA4: case 0xAC: // LD
+            case 0x85: case 0x8D: case 0x86: case 0x8E: case 0x84: case 0x8C:                                  // ST
+            case 0x29: case 0x25: case 0x2D: case 0x09: case 0x05: case 0x0D: case 0x49: case 0x45: case 0x4D: // AND, ORA, EOR
+            case 0x69: case 0x65: case 0x6D: case 0xE9: case 0xE5: case 0xED:                                  // ADC, SBC
+            case 0xC9: case 0xC5: case 0xCD: case 0xE0: case 0xE4: case 0xEC: case 0xC0: case 0xC4: case 0xCC: // CMP, CPX, CPY
+            case 0x24: case 0x2C:                                                                              // BIT
+            case 0xAA: case 0x8A: case 0xA8: case 0x98: case 0xBA: case 0x9A:                                  // transfer
+            case 0xE8: case 0xC8: case 0xCA: case 0x88:                                                        // INX, INY, DEX, DEY
+            case 0x18: case 0x38: case 0x58: case 0x78: case 0xB8: case 0xEA:                                  // flags, NOP
+            case 0x0A: case 0x4A: case 0x2A: case 0x6A:                                                        // ASL, LSR, ROL, ROR (A)
+                break;
+            default: return false;
+        }
+        // load the operand to ECX
+        if (1 == mode) {
+            e.movi(JitEmitter::ECX, op->code[1]);
+        } else if (2 <= mode) {
+            spillRegisters(e, next, progress, progress->clocks + op->length); // the access follows the fetch of the opcode and the operand
+            e.u8(0x48), e.u8(0x89), e.u8(0xDF); // mov rdi, rbx
+            e.movi(JitEmitter::ESI, addr);
+            if (isStore) {
+                e.mov(JitEmitter::EDX, getJitRegister(opcode));
+                e.call((const void*)jitWrite);
+                e.test(JitEmitter::EAX, JitEmitter::EAX);
+                *stop = e.jnz();
+                return true;
+            }
+            e.call((const void*)jitRead);
+            e.mov(JitEmitter::EDI, JitEmitter::EAX);
+            e.shr(JitEmitter::EDI, 8);
+            e.movzx8(JitEmitter::ECX, JitEmitter::EAX);
+        }
+        int r = getJitRegister(opcode);
+        switch (opcode) {
+            case 0xA9: case 0xA5: case 0xAD: case 0xA2: case 0xA6: case 0xAE: case 0xA0: case 0xA4: case 0xAC: // LD
+                e.mov(r, JitEmitter::ECX);
+                e.nz(r);
+                break;
+            case 0x29: case 0x25: case 0x2D: e.and_(JitEmitter::RA, JitEmitter::ECX), e.nz(JitEmitter::RA); break;
+            case 0x09: case 0x05: case 0x0D: e.or_(JitEmitter::RA, JitEmitter::ECX), e.nz(JitEmitter::RA); break;
+            case 0x49: case 0x45: case 0x4D: e.xor_(JitEmitter::RA, JitEmitter::ECX), e.nz(JitEmitter::RA); break;
+            case 0x69: case 0x65: case 0x6D: // ADC
+            case 0xE9: case 0xE5: case 0xED: // SBC
+                if (0xE0 <= opcode) e.xori(JitEmitter::ECX, 0xFF); // To ones' complement
+                e.mov(JitEmitter::EAX, JitEmitter::RP);
+                e.andi(JitEmitter::EAX, 0x01);
+                e.add(JitEmitter::EAX, JitEmitter::RA);
+                e.add(JitEmitter::EAX, JitEmitter::ECX); // EAX = A + value + C
+                e.mov(JitEmitter::EDX, JitEmitter::RA);
+                e.xor_(JitEmitter::EDX, JitEmitter::ECX);
+                e.not_(JitEmitter::EDX);
+                e.mov(JitEmitter::ESI, JitEmitter::RA);
+                e.xor_(JitEmitter::ESI, JitEmitter::EAX);
+                e.and_(JitEmitter::EDX, JitEmitter::ESI);
+                e.andi(JitEmitter::EDX, 0x80);
+                e.shr(JitEmitter::EDX, 1); // EDX = V
+                e.andi(JitEmitter::RP, 0xBE);
+                e.or_(JitEmitter::RP, JitEmitter::EDX);
+                e.mov(JitEmitter::EDX, JitEmitter::EAX);
+                e.shr(JitEmitter::EDX, 8); // EDX = C
+                e.or_(JitEmitter::RP, JitEmitter::EDX);
+                e.andi(JitEmitter::EAX, 0xFF);
+                e.mov(JitEmitter::RA, JitEmitter::EAX);
+                e.nz(JitEmitter::RA);
+                break;
+            case 0xC9: case 0xC5: case 0xCD: case 0xE0: case 0xE4: case 0xEC: case 0xC0: case 0xC4: case 0xCC: // CMP, CPX, CPY
+                e.andi(JitEmitter::RP, 0xFE);
+                e.mov(JitEmitter::EAX, r);
+                e.sub(JitEmitter::EAX, JitEmitter::ECX);
+                e.setcc(0x3, JitEmitter::EDX); // setae dl
+                e.movzx8(JitEmitter::EDX, JitEmitter::EDX);
+                e.or_(JitEmitter::RP, JitEmitter::EDX);
+                e.andi(JitEmitter::EAX, 0xFF);
+                e.nz(JitEmitter::EAX);
+                break;
+            case 0x24: case 0x2C: // BIT
+                e.andi(JitEmitter::RP, 0x3D);
+                e.mov(JitEmitter::EDX, JitEmitter::ECX);
+                e.andi(JitEmitter::EDX, 0xC0);
+                e.or_(JitEmitter::RP, JitEmitter::EDX);
+                e.mov(JitEmitter::EDX, JitEmitter::RA);
+                e.test(JitEmitter::EDX, JitEmitter::ECX);
+                e.setcc(0x4, JitEmitter::EDX); // setz dl
+                e.movzx8(JitEmitter::EDX, JitEmitter::EDX);
+                e.add(JitEmitter::EDX, JitEmitter::EDX);
+                e.or_(JitEmitter::RP, JitEmitter::EDX);
+                break;
+            case 0xAA: e.mov(JitEmitter::RX, JitEmitter::RA), e.nz(JitEmitter::RX); break; // TAX
+            case 0x8A: e.mov(JitEmitter::RA, JitEmitter::RX), e.nz(JitEmitter::RA); break; // TXA
+            case 0xA8: e.mov(JitEmitter::RY, JitEmitter::RA), e.nz(JitEmitter::RY); break; // TAY
+            case 0x98: e.mov(JitEmitter::RA, JitEmitter::RY), e.nz(JitEmitter::RA); break; // TYA
+            case 0xBA: e.load8(JitEmitter::RX, offsetOf(&R.s)), e.nz(JitEmitter::RX); break; // TSX
+            case 0x9A: e.store8(offsetOf(&R.s), JitEmitter::RX); break; // TXS
+            case 0xE8: e.addi(JitEmitter::RX, 1), e.andi(JitEmitter::RX, 0xFF), e.nz(JitEmitter::RX); break; // INX
+            case 0xC8: e.addi(JitEmitter::RY, 1), e.andi(JitEmitter::RY, 0xFF), e.nz(JitEmitter::RY); break; // INY
+            case 0xCA: e.addi(JitEmitter::RX, 0xFF), e.andi(JitEmitter::RX, 0xFF), e.nz(JitEmitter::RX); break; // DEX
+            case 0x88: e.addi(JitEmitter::RY, 0xFF), e.andi(JitEmitter::RY, 0xFF), e.nz(JitEmitter::RY); break; // DEY
+            case 0x18: e.andi(JitEmitter::RP, 0xFE); break; // CLC
+            case 0x38: e.ori(JitEmitter::RP, 0x01); break;  // SEC
+            case 0x58: e.andi(JitEmitter::RP, 0xFB); break; // CLI
+            case 0x78: e.ori(JitEmitter::RP, 0x04); break;  // SEI
+            case 0xB8: e.andi(JitEmitter::RP, 0xBF); break; // CLV
+            case 0xEA: break;                              // NOP
+            case 0x0A: // ASL
+                e.mov(JitEmitter::EAX, JitEmitter::RA);
+                e.shr(JitEmitter::EAX, 7);
+                e.andi(JitEmitter::RP, 0xFE);
+                e.or_(JitEmitter::RP, JitEmitter::EAX);
+                e.shl(JitEmitter::RA, 1);
+                e.andi(JitEmitter::RA, 0xFF);
+                e.nz(JitEmitter::RA);
+                break;
+            case 0x4A: // LSR
+                e.mov(JitEmitter::EAX, JitEmitter::RA);
+                e.andi(JitEmitter::EAX, 0x01);
+                e.andi(JitEmitter::RP, 0xFE);
+                e.or_(JitEmitter::RP, JitEmitter::EAX);
+                e.shr(JitEmitter::RA, 1);
+                e.nz(JitEmitter::RA);
+                break;
+            case 0x2A: // ROL (the carry is the bit 7 of A, same as rol())
+                e.mov(JitEmitter::EAX, JitEmitter::RA);
+                e.shr(JitEmitter::EAX, 7);
+                e.andi(JitEmitter::RP, 0xFE);
+                e.or_(JitEmitter::RP, JitEmitter::EAX);
+                e.shl(JitEmitter::RA, 1);
+                e.or_(JitEmitter::RA, JitEmitter::EAX);
+                e.andi(JitEmitter::RA, 0xFF);
+                e.nz(JitEmitter::RA);
+                break;
+            case 0x6A: // ROR (the carry is the bit 0 of A, same as ror())
+                e.mov(JitEmitter::EAX, JitEmitter::RA);
+                e.andi(JitEmitter::EAX, 0x01);
+                e.andi(JitEmitter::RP, 0xFE);
+                e.or_(JitEmitter::RP, JitEmitter::EAX);
+                e.shl(JitEmitter::EAX, 7);
+                e.shr(JitEmitter::RA, 1);
+                e.or_(JitEmitter::RA, JitEmitter::EAX);
+                e.nz(JitEmitter::RA);
+                break;
+        }
+        if (2 <= mode) {
+            e.test(JitEmitter::EDI, JitEmitter::EDI);
+            *stop = e.jnz();
+        }
+        return true;
+    }
+
+    // store the registers, the clocks and R.tickCount before calling the memory bus (the callbacks can refer them)
+    inline void spillRegisters(JitEmitter& e, unsigned short pc, JitProgress* progress, int clocks)
+    {
+        e.store8(offsetOf(&R.a), JitEmitter::RA);
+        e.store8(offsetOf(&R.x), JitEmitter::RX);
+        e.store8(offsetOf(&R.y), JitEmitter::RY);
+        e.store8(offsetOf(&R.p), JitEmitter::RP);
+        e.store16i(offsetOf(&R.pc), pc);
+        if (clocks != progress->writtenClocks) {
+            e.add32i(offsetOf(&this->clockConsumed), clocks - progress->writtenClocks);
+            progress->writtenClocks = clocks;
+        }
+        if (progress->ticks != progress->writtenTicks) {
+            e.add32i(offsetOf(&R.tickCount), progress->ticks - progress->writtenTicks);
+            progress->writtenTicks = progress->ticks;
+        }
+    }
+
+    // translate the leading operations of the block into x86-64 machine code
+    // (the executable memory is writable only while emitting the code)
+    inline void compileBlock(Block* block)
+    {
+        if (!PD->jitBuffer) {
+            void* buffer = mmap(NULL, M6502_JIT_BUFFER_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (MAP_FAILED == buffer) {
+                block->jitFailed = true;
+                return;
+            }
+            PD->jitBuffer = (unsigned char*)buffer;
+        } else if (mprotect(PD->jitBuffer, M6502_JIT_BUFFER_SIZE, PROT_READ | PROT_WRITE)) {
+            block->jitFailed = true;
+            return;
+        }
+        emitBlock(block);
+        if (mprotect(PD->jitBuffer, M6502_JIT_BUFFER_SIZE, PROT_READ | PROT_EXEC)) {
+            block->jit = NULL;
+            block->jitFailed = true;
+            PD->blockInvalidated = true; // the translated code in the memory is not executable
+        }
+    }
+
+    inline void emitBlock(Block* block)
+    {
+        unsigned char* start = PD->jitBuffer + PD->jitUsed;
+        JitEmitter e(start, PD->jitBuffer + M6502_JIT_BUFFER_SIZE);
+        e.push(JitEmitter::EBX);
+        e.push(JitEmitter::RA);
+        e.push(JitEmitter::RX);
+        e.push(JitEmitter::RY);
+        e.push(JitEmitter::RP);
+        e.u8(0x48), e.u8(0x89), e.u8(0xFB); // mov rbx, rdi
+        e.load8(JitEmitter::RA, offsetOf(&R.a));
+        e.load8(JitEmitter::RX, offsetOf(&R.x));
+        e.load8(JitEmitter::RY, offsetOf(&R.y));
+        e.load8(JitEmitter::RP, offsetOf(&R.p));
+        unsigned char* stops[M6502_BLOCK_MAX_OPERATIONS];
+        int cycles[M6502_BLOCK_MAX_OPERATIONS + 1];
+        unsigned short pc[M6502_BLOCK_MAX_OPERATIONS + 1];
+        JitProgress progress[M6502_BLOCK_MAX_OPERATIONS + 1]; // progress[i]: written back when the operation i has executed
+        int count = 0;
+        cycles[0] = 0;
+        pc[0] = block->addr;
+        memset(&progress[0], 0, sizeof(progress[0]));
+        bool decimal = false;
+        while (count < block->count) {
+            const BlockOperation* op = &block->operations[count];
+            unsigned short next = pc[count] + op->length;
+            JitProgress current = progress[count];
+            current.clocks = cycles[count];
+            current.ticks = count + 1;
+            if (!emitOperation(e, op, next, &stops[count], &current)) break;
+            unsigned char opcode = op->code[0];
+            decimal = decimal || opcode == 0x69 || opcode == 0x65 || opcode == 0x6D || opcode == 0xE9 || opcode == 0xE5 || opcode == 0xED;
+            count++;
+            cycles[count] = cycles[count - 1] + getBaseCycles(opcode);
+            pc[count] = next;
+            progress[count] = current;
+        }
+        if (!count) {
+            block->jitFailed = true;
+            return;
+        }
+        // exit stubs (EAX = consumed clocks, ECX = executed operations, EDX = PC: excluding the written back clocks and ticks)
+        unsigned char* exits[M6502_BLOCK_MAX_OPERATIONS + 1];
+        unsigned char* jumps[M6502_BLOCK_MAX_OPERATIONS + 1];
+        for (int i = count; 1 <= i; i--) {
+            exits[i] = e.ptr;
+            e.movi(JitEmitter::EAX, cycles[i] - progress[i].writtenClocks);
+            e.movi(JitEmitter::ECX, i - progress[i].writtenTicks);
+            e.movi(JitEmitter::EDX, pc[i]);
+            jumps[i] = i == 1 ? NULL : e.jmp();
+        }
+        unsigned char* epilogue = e.ptr;
+        e.store8(offsetOf(&R.a), JitEmitter::RA);
+        e.store8(offsetOf(&R.x), JitEmitter::RX);
+        e.store8(offsetOf(&R.y), JitEmitter::RY);
+        e.store8(offsetOf(&R.p), JitEmitter::RP);
+        e.store16(offsetOf(&R.pc), JitEmitter::EDX);
+        e.add32(offsetOf(&R.tickCount), JitEmitter::ECX);
+        e.pop(JitEmitter::RP);
+        e.pop(JitEmitter::RY);
+        e.pop(JitEmitter::RX);
+        e.pop(JitEmitter::RA);
+        e.pop(JitEmitter::EBX);
+        e.u8(0xC3); // ret
+        if (e.isOverflow()) {
+            PD->blockInvalidated = true; // the executable memory will be reused after discarding the all blocks
+            return;
+        }
+        for (int i = 2; i <= count; i++) e.patch(jumps[i], epilogue);
+        for (int i = 0; i < count; i++) {
+            if (stops[i]) e.patch(stops[i], exits[i + 1]);
+        }
+        PD->jitUsed = e.ptr - PD->jitBuffer;
+        block->jit = (int (*)(M6502T*))start;
+        block->jitCount = count;
+        block->jitDecimal = decimal;
+    }
+#endif
+
+    inline Block* findBlock(Block* previous)
+    {
+        if (previous) {
+            if (previous->next[0] && previous->next[0]->addr == R.pc) return previous->next[0];
+            if (previous->next[1] && previous->next[1]->addr == R.pc) return previous->next[1];
+        }
+        if (!isPredecodeArea(R.pc)) return NULL;
+        Block** page = PD->blockPages[R.pc >> 8];
+        if (!page) {
+            page = new Block*[256];
+            memset(page, 0, sizeof(Block*) * 256);
+            PD->blockPages[R.pc >> 8] = page;
+        }
+        Block* block = page[R.pc & 0xFF];
+        if (!block) {
+            block = buildBlock(R.pc);
+            if (!block) return NULL;
+            page[R.pc & 0xFF] = block;
+        }
+        if (previous) previous->next[previous->next[0] ? 1 : 0] = block;
+        return block;
+    }
+
+    // make a basic block from the predecoded operations (returns NULL if it contains operations that are not predecoded yet)
+    inline Block* buildBlock(unsigned short addr)
+    {
+        Block* block = new Block();
+        block->addr = addr;
+        while (block->count < M6502_BLOCK_MAX_OPERATIONS && isPredecodeArea(addr)) {
+            PredecodeEntry* page = PD->pages[addr >> 8];
+            PredecodeEntry* entry = page ? &page[addr & 0xFF] : NULL;
+            if (!entry || !entry->length) {
+                delete block;
+                return NULL;
+            }
+            unsigned char opcode = entry->code[0];
+            void (*operand)(M6502T*) = operandTables[isSupportBCD() ? 0 : 1].operands[opcode];
+            if (!operand) break; // unknown operation will be executed by the step
+            BlockOperation* op = &block->operations[block->count++];
+            op->operand = operand;
+            memcpy(op->code, entry->code, sizeof(op->code));
+            op->length = entry->length;
+            block->cycles += getBaseCycles(opcode);
+            block->maxCycles += getBaseCycles(opcode) + getPenaltyCycles(opcode);
+            addr += entry->length;
+            if (isBlockTerminator(opcode)) break;
+        }
+        if (!block->count) {
+            delete block;
+            return NULL;
+        }
+        for (int i = 0; i + 1 < block->count; i++) {
+            BlockOperation* op = &block->operations[i];
+            op->fusion = getFusion(op[0].code[0], op[1].code[0]);
+            if (op->fusion) i++;
+        }
+        PD->blockCount++;
+        return block;
+    }
+
+    // boundary between the operations of a superinstruction (returns false if the second operation must not be executed)
+    inline bool fuseBoundary(BlockOperation* op)
+    {
+        PD->replay = NULL;
+        flushClocks(); // the batched clocks are notified at every operation boundary
+        if (R.interrupt || PD->blockInvalidated) return false;
+        R.tickCount++;
+        R.pc++;
+        consumeClock(); // fetch the opcode
+        PD->replay = &op[1].code[1];
+        return true;
+    }
+
+    // execute an operation and the following BEQ or BNE as a superinstruction
+    // (the branch is decided by the result of the first operation instead of the evaluation of Z)
+    template <unsigned char (*First)(M6502T*), bool Equal>
+    static int fuseBranch(M6502T* cpu, BlockOperation* op)
+    {
+        cpu->PD->replay = &op[0].code[1];
+        unsigned char result = First(cpu);
+        if (!cpu->fuseBoundary(op)) return 1;
+        cpu->branch(Equal ? "BEQ" : "BNE", Equal ? 0 == result : 0 != result);
+        return 2;
+    }
+
+    // the first operations of the superinstructions (returns the result that decides Z)
+    static inline unsigned char dex_result(M6502T* cpu) { return cpu->R.x = cpu->dec("DEX", cpu->R.x); }
+    static inline unsigned char dey_result(M6502T* cpu) { return cpu->R.y = cpu->dec("DEY", cpu->R.y); }
+    static inline unsigned char inx_result(M6502T* cpu) { return cpu->R.x = cpu->inc("INX", cpu->R.x); }
+    static inline unsigned char iny_result(M6502T* cpu) { return cpu->R.y = cpu->inc("INY", cpu->R.y); }
+    inline unsigned char cpResult(const char* mne, unsigned char m, unsigned char value)
+    {
+        cp(mne, m, value);
+        return (unsigned char)(m - value);
+    }
+    static inline unsigned char cmp_imm_result(M6502T* cpu) { return cpu->cpResult("CMP", cpu->R.a, cpu->readImmediate()); }
+    static inline unsigned char cmp_zpg_result(M6502T* cpu) { return cpu->cpResult("CMP", cpu->R.a, cpu->readZeroPage(NULL)); }
+    static inline unsigned char cmp_abs_result(M6502T* cpu) { return cpu->cpResult("CMP", cpu->R.a, cpu->readAbsolute(NULL)); }
+    static inline unsigned char cpx_imm_result(M6502T* cpu) { return cpu->cpResult("CPX", cpu->R.x, cpu->readImmediate()); }
+    static inline unsigned char cpy_imm_result(M6502T* cpu) { return cpu->cpResult("CPY", cpu->R.y, cpu->readImmediate()); }
+    static inline unsigned char inc_zpg_result(M6502T* cpu)
+    {
+        unsigned short addr;
+        unsigned char before = cpu->readZeroPage(&addr);
+        unsigned char after = cpu->inc("INC", before);
+        cpu->writeMemoryWithDummy(addr, before, after);
+        return after;
+    }
+    static inline unsigned char dec_zpg_result(M6502T* cpu)
+    {
+        unsigned short addr;
+        unsigned char before = cpu->readZeroPage(&addr);
+        unsigned char after = cpu->dec("DEC", before);
+        cpu->writeMemoryWithDummy(addr, before, after);
+        return after;
+    }
+
+    // returns the superinstruction of the frequent pairs (or NULL)
+    static inline int (*getFusion(unsigned char first, unsigned char second))(M6502T*, BlockOperation*)
+    {
+        switch (first << 8 | second) {
+            case 0xCAD0: return fuseBranch<dex_result, false>;     // DEX / BNE
+            case 0x88D0: return fuseBranch<dey_result, false>;     // DEY / BNE
+            case 0xE8D0: return fuseBranch<inx_result, false>;     // INX / BNE
+            case 0xC8D0: return fuseBranch<iny_result, false>;     // INY / BNE
+            case 0xC9F0: return fuseBranch<cmp_imm_result, true>;  // CMP #imm / BEQ
+            case 0xC9D0: return fuseBranch<cmp_imm_result, false>; // CMP #imm / BNE
+            case 0xC5F0: return fuseBranch<cmp_zpg_result, true>;  // CMP zpg / BEQ
+            case 0xC5D0: return fuseBranch<cmp_zpg_result, false>; // CMP zpg / BNE
+            case 0xCDF0: return fuseBranch<cmp_abs_result, true>;  // CMP abs / BEQ
+            case 0xCDD0: return fuseBranch<cmp_abs_result, false>; // CMP abs / BNE
+            case 0xE0D0: return fuseBranch<cpx_imm_result, false>; // CPX #imm / BNE
+            case 0xC0D0: return fuseBranch<cpy_imm_result, false>; // CPY #imm / BNE
+            case 0xE6D0: return fuseBranch<inc_zpg_result, false>; // INC zpg / BNE
+            case 0xC6D0: return fuseBranch<dec_zpg_result, false>; // DEC zpg / BNE
+            default: return NULL;
+        }
+    }
+
+    inline void flushBlocks()
+    {
+        if (!PD) return;
+        for (int i = 0; i < 256; i++) {
+            Block** page = PD->blockPages[i];
+            if (!page) continue;
+            for (int j = 0; j < 256; j++) {
+                if (page[j]) delete page[j];
+            }
+            memset(page, 0, sizeof(Block*) * 256);
+        }
+        PD->blockCount = 0;
+        PD->blockInvalidated = false;
+        PD->jitUsed = 0;
+    }
+
+    static inline int getBaseCycles(unsigned char opcode)
+    {
+        static const unsigned char cycles[256] = {
+            7, 6, 0, 0, 0, 3, 5, 0, 3, 2, 2, 0, 0, 4, 6, 0, // $00
+            2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0, // $10
+            6, 6, 0, 0, 3, 3, 5, 0, 4, 2, 2, 0, 4, 4, 6, 0, // $20
+            2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0, // $30
+            6, 6, 0, 0, 0, 3, 5, 0, 3, 2, 2, 0, 3, 4, 6, 0, // $40
+            2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0, // $50
+            6, 6, 0, 0, 0, 3, 5, 0, 4, 2, 2, 0, 5, 4, 6, 0, // $60
+            2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0, // $70
+            0, 6, 0, 0, 3, 3, 3, 0, 2, 0, 2, 0, 4, 4, 4, 0, // $80
+            2, 6, 0, 0, 4, 4, 4, 0, 2, 5, 2, 0, 0, 5, 0, 0, // $90
+            2, 6, 2, 0, 3, 3, 3, 0, 2, 2, 2, 0, 4, 4, 4, 0, // $A0
+            2, 5, 0, 0, 4, 4, 4, 0, 2, 4, 2, 0, 4, 4, 4, 0, // $B0
+            2, 6, 0, 0, 3, 3, 5, 0, 2, 2, 2, 0, 4, 4, 6, 0, // $C0
+            2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0, // $D0
+            2, 6, 0, 0, 3, 3, 5, 0, 2, 2, 2, 0, 4, 4, 6, 0, // $E0
+            2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0, // $F0
+        };
+        return cycles[opcode];
+    }
+
+    static inline int getPenaltyCycles(unsigned char opcode)
+    {
+        if ((opcode & 0x1F) == 0x10) return 2;          // branch (taken + page crossover)
+        if (opcode == 0xBC || opcode == 0xBE) return 1; // LDY absX, LDX absY (page overflow)
+        switch (opcode & 0x1F) {
+            case 0x11: // indY
+            case 0x19: // absY
+            case 0x1D: // absX
+                return (opcode & 0xE0) == 0x80 ? 0 : 1; // page overflow (STA always consumes the penalty cycle)
+            default: return 0;
+        }
+    }
+
+    static inline bool isBlockTerminator(unsigned char opcode)
     {
-        this->mode = mode;
-        memset(&R, 0, sizeof(R));
-        CB.readMemory = readMemory;
-        CB.writeMemory = writeMemory;
-        CB.debugMessage = NULL;
-        CB.consumeClock = NULL;
-        CB.breakPoints.clear();
-        CB.breakOperands.clear();
-        CB.arg = arg;
-        setupOperands();
-        reset();
+        if ((opcode & 0x1F) == 0x10) return true; // branch
+        switch (opcode) {
+            case 0x00: // BRK
+            case 0x20: // JSR
+            case 0x40: // RTI
+            case 0x4C: // JMP abs
+            case 0x60: // RTS
+            case 0x6C: // JMP ind
+                return true;
+            default: return false;
+        }
     }
 
-    ~M6502()
+    inline void executedOperand(bool executed)
     {
-        removeAllBreakPoints();
-        removeAllBreakOperands();
+        if (isPredecode()) endPredecode();
+        if (executed) {
+            if (isDebug()) {
+                syncStatus();
+                char buf[1024];
+                sprintf(buf, "[$%04X] %s %s", DD.pc, DD.mne, DD.opp);
+                CB.debugMessage(CB.arg, buf);
+            }
+        } else {
+            raiseError(M6502_ERROR_UNKNOWN_OPERAND);
+        }
+        if (isTrace()) {
+            syncStatus();
+            getTraceRegisters(&TR.after);
+            TR.cycles = this->clockConsumed - traceClocks;
+            CB.trace(CB.arg, &TR);
+        }
+        flushClocks();
     }
 
-    /**
-     * Execute
-     * - [i] clocks: number of clocks expected to execute CPU
-     * - [i] executeUntilNMI: execute CPU until NMI (clocks will be ignored)
-     * - return: number of clocks actually executed
-     */
-    int execute(int clocks, bool executeUntilNMI = false)
+    inline void getTraceRegisters(M6502TraceEvent::Registers* registers)
     {
-        this->clockConsumed = 0;
-        while (this->clockConsumed < clocks || executeUntilNMI) {
-            R.tickCount++;
-            for (auto bp : CB.breakPoints) {
-                if (bp->addr == R.pc) {
-                    bp->callback(CB.arg);
-                }
+        registers->pc = R.pc;
+        registers->a = R.a;
+        registers->x = R.x;
+        registers->y = R.y;
+        registers->p = R.p;
+        registers->s = R.s;
+    }
+
+    inline unsigned char fetchOperand()
+    {
+        R.tickCount++;
+        if (isSupportBreak() && CB.breakPointMap && (CB.breakPointMap[R.pc >> 3] & (1 << (R.pc & 7)))) {
+            unsigned short pc = R.pc;
+            for (size_t i = findBreakPoint(pc); i < CB.breakPoints.size() && CB.breakPoints[i].addr == pc; i++) {
+                BreakPoint* bp = &CB.breakPoints[i];
+                bp->hits++;
+                syncStatus();
+                if (bp->condition.empty() || evaluateCondition(bp)) bp->callback(CB.arg);
             }
+        }
+        if (isDebug()) {
             DD.pc = R.pc;
             DD.mne[0] = '\0';
             DD.opp[0] = '\0';
-            unsigned char opcode = fetch();
-            for (auto bo : CB.breakOperands) {
-                if (bo->operand == opcode) {
-                    bo->callback(CB.arg);
-                }
-            }
-            void (*operand)(M6502*) = operands[opcode];
-            if (operand) {
-                operand(this);
-                if (CB.debugMessage) {
-                    char buf[1024];
-                    sprintf(buf, "[$%04X] %s %s", DD.pc, DD.mne, DD.opp);
-                    CB.debugMessage(CB.arg, buf);
-                }
-            } else {
-                if (CB.onError) CB.onError(CB.arg, M6502_ERROR_UNKNOWN_OPERAND);
+        }
+        if (isTrace()) {
+            syncStatus();
+            getTraceRegisters(&TR.before);
+            TR.length = 0;
+            TR.addr = -1;
+            traceClocks = this->clockConsumed;
+        }
+        if (isPredecode()) beginPredecode();
+        unsigned char opcode = fetch();
+        if (isSupportBreak() && (CB.breakOperandMap[opcode >> 3] & (1 << (opcode & 7)))) {
+            for (size_t i = findBreakOperand(opcode); i < CB.breakOperands.size() && CB.breakOperands[i].operand == opcode; i++) {
+                syncStatus();
+                CB.breakOperands[i].callback(CB.arg);
             }
-            if (R.interrupt & 0b01) {
-                if (R.interrupt & 0b10) {
-                    if (CB.debugMessage) CB.debugMessage(CB.arg, "EXECUTE NMI");
-                    consumeClock();
-                    executeInterrupt(0xFFFA, false);
-                    consumeClock();
-                    executeUntilNMI = false;
-                } else if (!getStatusI()) {
-                    if (CB.debugMessage) CB.debugMessage(CB.arg, "EXECUTE IRQ");
-                    consumeClock();
-                    executeInterrupt(0xFFFE, false);
-                    consumeClock();
+        }
+        return opcode;
+    }
+
+    inline void updateWatchMap()
+    {
+        if (CB.watchPoints.empty()) {
+            if (CB.watchPage) delete[] CB.watchPage;
+            CB.watchPage = NULL;
+            CB.watchMap[0] = NULL;
+            CB.watchMap[1] = NULL;
+            return;
+        }
+        if (!CB.watchPage) {
+            CB.watchPage = new unsigned char[0x100 + 0x2000 * 2];
+            CB.watchMap[0] = CB.watchPage + 0x100;
+            CB.watchMap[1] = CB.watchMap[0] + 0x2000;
+        }
+        memset(CB.watchPage, 0, 0x100 + 0x2000 * 2);
+        for (auto& wp : CB.watchPoints) {
+            for (int addr = wp.addrFrom; addr <= wp.addrTo; addr++) {
+                CB.watchPage[addr >> 8] |= wp.access;
+                for (int i = 0; i < 2; i++) {
+                    if (wp.access & (1 << i)) CB.watchMap[i][addr >> 3] |= 1 << (addr & 7);
                 }
-                R.interrupt = 0;
             }
         }
-        return this->clockConsumed;
     }
 
-    /**
-     * Execute an interrupt request (IRQ)
-     */
-    void IRQ() { R.interrupt |= 0b01; }
-
-    /**
-     * Execute a non-maskable interrupt (NMI)
-     */
-    void NMI() { R.interrupt |= 0b11; }
-
-    /**
-     * Execute a reset interrupt
-     */
-    void reset()
+    inline bool isWatchAddress(unsigned short addr, int access)
     {
-        R.tickCount = 0;
-        R.s = 0;
-        consumeClock();
-        updateStatusI(true, true);
-        updateStatusB(false, true);
-        push(0);
-        unsigned char pcL = readMemory(0xFFFC);
-        unsigned char pcH = readMemory(0xFFFD);
-        R.pc = pcH;
-        R.pc <<= 8;
-        R.pc |= pcL;
-        consumeClock();
-        consumeClock();
-        consumeClock();
+        if (!isSupportBreak() || !CB.watchPage || !(CB.watchPage[addr >> 8] & access)) return false;
+        return CB.watchMap[access - 1][addr >> 3] & (1 << (addr & 7));
     }
 
-    /**
-     * Explicit consume of the CPU clock(s)
-     * - return: number of CPU clocks to consume
-     */
-    void consumeClock(int clocks)
+    inline void watch(int access, unsigned short addr, unsigned char value)
     {
-        for (int i = 0; i < clocks; i++) {
-            consumeClock();
+        for (size_t i = 0; i < CB.watchPoints.size(); i++) {
+            WatchPoint* wp = &CB.watchPoints[i];
+            if ((wp->access & access) && wp->addrFrom <= addr && addr <= wp->addrTo) {
+                syncStatus();
+                wp->callback(CB.arg, access, addr, value);
+            }
         }
     }
 
-    /**
-     * Set the callback function that called when consumed a CPU clock
-     * - [i] callback: function pointer
-     */
-    void setConsumeClock(void (*callback)(void* arg) = NULL)
+    // returns the index of the first break point of the address (or CB.breakPoints.size())
+    inline size_t findBreakPoint(unsigned short addr)
     {
-        CB.consumeClock = callback;
+        auto it = std::lower_bound(CB.breakPoints.begin(), CB.breakPoints.end(), addr, [](const BreakPoint& bp, unsigned short addr) { return bp.addr < addr; });
+        return it != CB.breakPoints.end() && it->addr == addr ? it - CB.breakPoints.begin() : CB.breakPoints.size();
     }
 
-    /**
-     * Set the callback function that called when executed an operand
-     * - [i] callback: function pointer
-     */
-    void setDebugMessage(void (*callback)(void* arg, const char* message) = NULL)
+    // returns the index of the first break operand of the operand code (or CB.breakOperands.size())
+    inline size_t findBreakOperand(unsigned char operand)
     {
-        CB.debugMessage = callback;
+        auto it = std::lower_bound(CB.breakOperands.begin(), CB.breakOperands.end(), operand, [](const BreakOperand& bo, unsigned char operand) { return bo.operand < operand; });
+        return it != CB.breakOperands.end() && it->operand == operand ? it - CB.breakOperands.begin() : CB.breakOperands.size();
     }
 
-    /**
-     * Set the callback function that called when detected an error
-     * - [i] callback: function pointer
-     */
-    void setOnError(void (*callback)(void* arg, int errorCode) = NULL)
+    // returns the index of the last break point of the address and the callback
+    inline size_t findBreakPoint(unsigned short addr, void (*callback)(void*))
     {
-        CB.onError = callback;
+        size_t result = findBreakPoint(addr);
+        for (size_t i = result; i < CB.breakPoints.size() && CB.breakPoints[i].addr == addr; i++) {
+            if (CB.breakPoints[i].callback == callback) result = i;
+        }
+        return result;
     }
 
-    /**
-     * Add a break point
-     * - [i] addr: address
-     * - [i] callback: detection callback function pointer
-     */
-    void addBreakPoint(unsigned short addr, void (*callback)(void*))
+    bool evaluateCondition(BreakPoint* bp)
+    {
+        int stack[M6502_CONDITION_STACK];
+        int sp = 0;
+        const int* code = bp->condition.data();
+        const int* end = code + bp->condition.size();
+        while (code < end) {
+            int op = *code++;
+            switch (op) {
+                case CC_NUM: stack[sp++] = *code++; continue;
+                case CC_A: stack[sp++] = R.a; continue;
+                case CC_X: stack[sp++] = R.x; continue;
+                case CC_Y: stack[sp++] = R.y; continue;
+                case CC_S: stack[sp++] = R.s; continue;
+                case CC_P: stack[sp++] = R.p; continue;
+                case CC_PC: stack[sp++] = R.pc; continue;
+                case CC_HITS: stack[sp++] = (int)bp->hits; continue;
+                case CC_MEM: stack[sp - 1] = peekMemory((unsigned short)stack[sp - 1]); continue;
+                case CC_NOT: stack[sp - 1] = !stack[sp - 1]; continue;
+                case CC_NEG: stack[sp - 1] = -stack[sp - 1]; continue;
+                case CC_INV: stack[sp - 1] = ~stack[sp - 1]; continue;
+            }
+            int right = stack[--sp];
+            int left = stack[sp - 1];
+            switch (op) {
+                case CC_OR: left = left || right; break;
+                case CC_AND: left = left && right; break;
+                case CC_BOR: left |= right; break;
+                case CC_BXOR: left ^= right; break;
+                case CC_BAND: left &= right; break;
+                case CC_EQ: left = left == right; break;
+                case CC_NE: left = left != right; break;
+                case CC_LE: left = left <= right; break;
+                case CC_GE: left = left >= right; break;
+                case CC_LT: left = left < right; break;
+                case CC_GT: left = left > right; break;
+                case CC_ADD: left += right; break;
+                case CC_SUB: left -= right; break;
+            }
+            stack[sp - 1] = left;
+        }
+        return stack[0] != 0;
+    }
+
+    // read the memory without the clock, the watch points and the clock synchronization
+    // read the memory without side effects: the low memory or the peek of the Bus (others are 0)
+    inline unsigned char peekMemory(unsigned short addr)
     {
-        CB.breakPoints.push_back(new BreakPoint(addr, callback));
+        unsigned char value;
+        if (isLowMemory(addr)) return lowMemory[addr];
+        return M6502BusPeek<Bus>::peek(bus, addr, &value) ? value : 0;
     }
 
-    /**
-     * Remove a break point
-     * - [i] callback: detection callback function pointer to remove
-     */
-    void removeBreakPoint(void (*callback)(void*))
+    inline bool isPredecodeArea(unsigned short addr)
     {
-        int index = 0;
-        for (auto bp : CB.breakPoints) {
-            if (bp->callback == callback) {
-                CB.breakPoints.erase(CB.breakPoints.begin() + index);
-                delete bp;
-                return;
-            }
-            index++;
-        }
+        return PD->area[addr >> 13] & (1U << ((addr >> 8) & 31)) ? true : false;
     }
 
-    /**
-     * Remove the all of break points
-     */
-    void removeAllBreakPoints()
+    inline void beginPredecode()
     {
-        for (auto bp : CB.breakPoints) delete bp;
-        CB.breakPoints.clear();
+        PD->replay = NULL;
+        PD->recordEntry = NULL;
+        if (!isPredecodeArea(R.pc)) return;
+        PredecodeEntry* page = PD->pages[R.pc >> 8];
+        if (!page) {
+            page = new PredecodeEntry[256];
+            memset(page, 0, sizeof(PredecodeEntry) * 256);
+            PD->pages[R.pc >> 8] = page;
+        }
+        PredecodeEntry* entry = &page[R.pc & 0xFF];
+        if (entry->length) {
+            PD->replay = entry->code;
+        } else {
+            PD->recordEntry = entry;
+            PD->recordAddr = R.pc;
+            PD->record.length = 0;
+        }
     }
 
-    /**
-     * Add a break operand
-     * - [i] operand: operand code
-     * - [i] callback: detection callback function pointer
-     */
-    void addBreakOperand(unsigned char operand, void (*callback)(void*))
+    inline void endPredecode()
     {
-        CB.breakOperands.push_back(new BreakOperand(operand, callback));
+        PD->replay = NULL;
+        if (!PD->recordEntry) return;
+        unsigned short lastAddr = PD->recordAddr + PD->record.length - 1;
+        if (isPredecodeArea(lastAddr)) *PD->recordEntry = PD->record;
+        PD->recordEntry = NULL;
     }
 
-    /**
-     * Remove a break operand
-     * - [i] callback: detection callback function pointer to remove
-     */
-    void removeBreakOperand(void (*callback)(void*))
+    // discard the predecoded operations that contain the written address
+    inline void invalidatePredecode(unsigned short addr)
     {
-        int index = 0;
-        for (auto bo : CB.breakOperands) {
-            if (bo->callback == callback) {
-                CB.breakOperands.erase(CB.breakOperands.begin() + index);
-                delete bo;
-                return;
+        if (!isPredecodeArea(addr)) return;
+        for (int i = 0; i < 3; i++) {
+            unsigned short a = addr - i;
+            PredecodeEntry* page = PD->pages[a >> 8];
+            if (page && i < page[a & 0xFF].length) {
+                page[a & 0xFF].length = 0;
+                if (PD->blockCount) PD->blockInvalidated = true;
             }
-            index++;
         }
+        if (PD->recordEntry && (unsigned short)(addr - PD->recordAddr) < 3) PD->recordEntry = NULL;
     }
 
-    /**
-     * Remove the all of break operands
-     */
-    void removeAllBreakOperands()
+    // returns true if NMI was executed
+    inline bool checkInterrupt()
     {
-        for (auto bo : CB.breakOperands) delete bo;
-        CB.breakOperands.clear();
+        if (!(R.interrupt & 0b01)) return false;
+        syncStatus();
+        bool nmi = R.interrupt & 0b10 ? true : false;
+        if (nmi) {
+            nmiExecuted = true;
+            if (isDebug()) CB.debugMessage(CB.arg, "EXECUTE NMI");
+            consumeClock();
+            executeInterrupt(0xFFFA, false);
+            consumeClock();
+        } else if (!getStatusI()) {
+            if (isDebug()) CB.debugMessage(CB.arg, "EXECUTE IRQ");
+            consumeClock();
+            executeInterrupt(0xFFFE, false);
+            consumeClock();
+        }
+        R.interrupt = 0;
+        return nmi;
+    }
+
+    // all operations are inlined into this function (M6502_ENGINE_SWITCH)
+    // The registers stay in R instead of the local variables of the loop: every bus access can call
+    // the user code that observes or changes R (the callbacks, setIRQ/setNMI and stall), so the locals
+    // would have to be spilled and reloaded around each of them, and the operations shared by all the
+    // engines would have to be duplicated to work on the locals.
+    // Therefore, this engine only removes the indirect call of the table and is not always faster.
+    inline bool executeOperandBySwitch(unsigned char opcode)
+    {
+        switch (opcode) {
+            case 0x00: brk(this); return true;
+            case 0x01: ora_x_ind(this); return true;
+            case 0x05: ora_zpg(this); return true;
+            case 0x06: asl_zpg(this); return true;
+            case 0x08: php(this); return true;
+            case 0x09: ora_imm(this); return true;
+            case 0x0A: asl_a(this); return true;
+            case 0x0D: ora_abs(this); return true;
+            case 0x0E: asl_abs(this); return true;
+            case 0x10: bpl_rel(this); return true;
+            case 0x11: ora_ind_y(this); return true;
+            case 0x15: ora_zpg_x(this); return true;
+            case 0x16: asl_zpg_x(this); return true;
+            case 0x18: clc(this); return true;
+            case 0x19: ora_abs_y(this); return true;
+            case 0x1D: ora_abs_x(this); return true;
+            case 0x1E: asl_abs_x(this); return true;
+            case 0x20: jsr_abs(this); return true;
+            case 0x21: and_x_ind(this); return true;
+            case 0x24: bit_zpg(this); return true;
+            case 0x25: and_zpg(this); return true;
+            case 0x26: rol_zpg(this); return true;
+            case 0x28: plp(this); return true;
+            case 0x29: and_imm(this); return true;
+            case 0x2A: rol_a(this); return true;
+            case 0x2C: bit_abs(this); return true;
+            case 0x2D: and_abs(this); return true;
+            case 0x2E: rol_abs(this); return true;
+            case 0x30: bmi_rel(this); return true;
+            case 0x31: and_ind_y(this); return true;
+            case 0x35: and_zpg_x(this); return true;
+            case 0x36: rol_zpg_x(this); return true;
+            case 0x38: sec(this); return true;
+            case 0x39: and_abs_y(this); return true;
+            case 0x3D: and_abs_x(this); return true;
+            case 0x3E: rol_abs_x(this); return true;
+            case 0x40: rti(this); return true;
+            case 0x41: eor_x_ind(this); return true;
+            case 0x45: eor_zpg(this); return true;
+            case 0x46: lsr_zpg(this); return true;
+            case 0x48: pha(this); return true;
+            case 0x49: eor_imm(this); return true;
+            case 0x4A: lsr_a(this); return true;
+            case 0x4C: jmp_abs(this); return true;
+            case 0x4D: eor_abs(this); return true;
+            case 0x4E: lsr_abs(this); return true;
+            case 0x50: bvc_rel(this); return true;
+            case 0x51: eor_ind_y(this); return true;
+            case 0x55: eor_zpg_x(this); return true;
+            case 0x56: lsr_zpg_x(this); return true;
+            case 0x58: cli(this); return true;
+            case 0x59: eor_abs_y(this); return true;
+            case 0x5D: eor_abs_x(this); return true;
+            case 0x5E: lsr_abs_x(this); return true;
+            case 0x60: rts(this); return true;
+            case 0x61: adc_x_ind(this); return true;
+            case 0x65: adc_zpg(this); return true;
+            case 0x66: ror_zpg(this); return true;
+            case 0x68: pla(this); return true;
+            case 0x69: adc_imm(this); return true;
+            case 0x6A: ror_a(this); return true;
+            case 0x6C: jmp_ind(this); return true;
+            case 0x6D: adc_abs(this); return true;
+            case 0x6E: ror_abs(this); return true;
+            case 0x70: bvs_rel(this); return true;
+            case 0x71: adc_ind_y(this); return true;
+            case 0x75: adc_zpg_x(this); return true;
+            case 0x76: ror_zpg_x(this); return true;
+            case 0x78: sei(this); return true;
+            case 0x79: adc_abs_y(this); return true;
+            case 0x7D: adc_abs_x(this); return true;
+            case 0x7E: ror_abs_x(this); return true;
+            case 0x81: sta_x_ind(this); return true;
+            case 0x84: sty_zpg(this); return true;
+            case 0x85: sta_zpg(this); return true;
+            case 0x86: stx_zpg(this); return true;
+            case 0x88: dey(this); return true;
+            case 0x8A: txa(this); return true;
+            case 0x8C: sty_abs(this); return true;
+            case 0x8D: sta_abs(this); return true;
+            case 0x8E: stx_abs(this); return true;
+            case 0x90: bcc_rel(this); return true;
+            case 0x91: sta_ind_y(this); return true;
+            case 0x94: sty_zpg_x(this); return true;
+            case 0x95: sta_zpg_x(this); return true;
+            case 0x96: stx_zpg_y(this); return true;
+            case 0x98: tya(this); return true;
+            case 0x99: sta_abs_y(this); return true;
+            case 0x9A: txs(this); return true;
+            case 0x9D: sta_abs_x(this); return true;
+            case 0xA0: ldy_imm(this); return true;
+            case 0xA1: lda_x_ind(this); return true;
+            case 0xA2: ldx_imm(this); return true;
+            case 0xA4: ldy_zpg(this); return true;
+            case 0xA5: lda_zpg(this); return true;
+            case 0xA6: ldx_zpg(this); return true;
+            case 0xA8: tay(this); return true;
+            case 0xA9: lda_imm(this); return true;
+            case 0xAA: tax(this); return true;
+            case 0xAC: ldy_abs(this); return true;
+            case 0xAD: lda_abs(this); return true;
+            case 0xAE: ldx_abs(this); return true;
+            case 0xB0: bcs_rel(this); return true;
+            case 0xB1: lda_ind_y(this); return true;
+            case 0xB4: ldy_zpg_x(this); return true;
+            case 0xB5: lda_zpg_x(this); return true;
+            case 0xB6: ldx_zpg_y(this); return true;
+            case 0xB8: clv(this); return true;
+            case 0xB9: lda_abs_y(this); return true;
+            case 0xBA: tsx(this); return true;
+            case 0xBC: ldy_abs_x(this); return true;
+            case 0xBD: lda_abs_x(this); return true;
+            case 0xBE: ldx_abs_y(this); return true;
+            case 0xC0: cpy_imm(this); return true;
+            case 0xC1: cmp_x_ind(this); return true;
+            case 0xC4: cpy_zpg(this); return true;
+            case 0xC5: cmp_zpg(this); return true;
+            case 0xC6: dec_zpg(this); return true;
+            case 0xC8: iny(this); return true;
+            case 0xC9: cmp_imm(this); return true;
+            case 0xCA: dex(this); return true;
+            case 0xCC: cpy_abs(this); return true;
+            case 0xCD: cmp_abs(this); return true;
+            case 0xCE: dec_abs(this); return true;
+            case 0xD0: bne_rel(this); return true;
+            case 0xD1: cmp_ind_y(this); return true;
+            case 0xD5: cmp_zpg_x(this); return true;
+            case 0xD6: dec_zpg_x(this); return true;
+            case 0xD8:
+                if (!isSupportBCD()) return false;
+                cld(this);
+                return true;
+            case 0xD9: cmp_abs_y(this); return true;
+            case 0xDD: cmp_abs_x(this); return true;
+            case 0xDE: dec_abs_x(this); return true;
+            case 0xE0: cpx_imm(this); return true;
+            case 0xE1: sbc_x_ind(this); return true;
+            case 0xE4: cpx_zpg(this); return true;
+            case 0xE5: sbc_zpg(this); return true;
+            case 0xE6: inc_zpg(this); return true;
+            case 0xE8: inx(this); return true;
+            case 0xE9: sbc_imm(this); return true;
+            case 0xEA: nop(this); return true;
+            case 0xEC: cpx_abs(this); return true;
+            case 0xED: sbc_abs(this); return true;
+            case 0xEE: inc_abs(this); return true;
+            case 0xF0: beq_rel(this); return true;
+            case 0xF1: sbc_ind_y(this); return true;
+            case 0xF5: sbc_zpg_x(this); return true;
+            case 0xF6: inc_zpg_x(this); return true;
+            case 0xF8:
+                if (!isSupportBCD()) return false;
+                sed(this);
+                return true;
+            case 0xF9: sbc_abs_y(this); return true;
+            case 0xFD: sbc_abs_x(this); return true;
+            case 0xFE: inc_abs_x(this); return true;
+            default: return false;
+        }
     }
 
-  private:
     inline void executeInterrupt(unsigned short addr, bool isBreak)
     {
         unsigned char pcH = (R.pc & 0xFF00) >> 8;
         unsigned char pcL = R.pc & 0x00FF;
         push(pcH);
         push(pcL);
+        syncStatus();
         push(R.p);
         updateStatusI(true);
         updateStatusB(isBreak);
-        pcL = readMemory(addr);
-        pcH = readMemory(addr + 1);
-        R.pc = pcH;
-        R.pc <<= 8;
-        R.pc |= pcL;
+        R.pc = readMemory16(addr);
+    }
+
+    inline bool isClockCallback() { return (Features & M6502_FEATURE_CLOCK) && CB.consumeClock; }
+    inline bool isClockBatch() { return (Features & M6502_FEATURE_CLOCK) && CB.consumeClocks && !CB.consumeClock; }
+    inline bool isClockSyncAddress(unsigned short addr) { return isClockSync() && (clockSync[addr >> 3] & (1 << (addr & 7))); }
+
+    // notify the clocks to the peripheral before accessing the clock sync area
+    inline void syncClocks(unsigned short addr)
+    {
+        flushClocks();
+        if (catchUpIndex && catchUpIndex[addr]) catchUp(&CB.catchUps[catchUpIndex[addr] - 1]);
+    }
+
+    inline void catchUp(CatchUp* catchUp)
+    {
+        unsigned long long clock = getClock();
+        if (catchUp->clock != clock) {
+            int clocks = (int)(clock - catchUp->clock);
+            catchUp->clock = clock;
+            syncStatus();
+            catchUp->callback(CB.arg, clocks);
+        }
+    }
+
+    // notify the clocks consumed since the last notification
+    inline void flushClocks()
+    {
+        if (isClockBatch() && this->clockNotified != this->clockConsumed) {
+            syncStatus();
+            int clocks = this->clockConsumed - this->clockNotified;
+            this->clockNotified = this->clockConsumed;
+            CB.consumeClocks(CB.arg, clocks);
+        }
     }
 
     inline void consumeClock()
     {
-        if (CB.consumeClock) {
+        if (isClockCallback()) {
+            syncStatus();
             CB.consumeClock(CB.arg);
         }
         this->clockConsumed++;
     }
 
+    // access to the memory bus without consuming the clock
+    inline unsigned char readBus(unsigned short addr)
+    {
+        unsigned char result;
+        if (isIdleSkip() && !isStableAddress(addr)) IL.dirty = true;
+        if (isLowMemory(addr)) {
+            result = lowMemory[addr];
+        } else {
+            if (isClockSyncAddress(addr)) syncClocks(addr);
+            result = bus.read(addr);
+        }
+        if (isWatchAddress(addr, M6502_WATCH_READ)) watch(M6502_WATCH_READ, addr, result);
+        return result;
+    }
+
+    inline void writeBus(unsigned short addr, unsigned char value)
+    {
+        if (isWatchAddress(addr, M6502_WATCH_WRITE)) watch(M6502_WATCH_WRITE, addr, value);
+        if (isIdleSkip()) IL.dirty = true;
+        if (isLowMemory(addr)) {
+            lowMemory[addr] = value;
+        } else {
+            if (isClockSyncAddress(addr)) syncClocks(addr);
+            bus.write(addr, value);
+        }
+        if (isPredecode()) invalidatePredecode(addr);
+    }
+
+    // zero page and stack ($0000-$01FF) bound by setLowMemory
+    inline bool isLowMemory(unsigned short addr)
+    {
+        return (Features & M6502_FEATURE_LOW_MEMORY) && addr < 0x200 && lowMemory;
+    }
+
     inline unsigned char readMemory(unsigned short addr)
     {
-        unsigned char result = CB.readMemory ? CB.readMemory(CB.arg, addr) : 0;
+        unsigned char result = readBus(addr);
         consumeClock();
         return result;
     }
 
     inline void writeMemory(unsigned short addr, unsigned char value)
     {
-        if (CB.writeMemory) CB.writeMemory(CB.arg, addr, value);
+        writeBus(addr, value);
         consumeClock();
     }
 
     inline void writeMemoryWithDummy(unsigned short addr, unsigned char before, unsigned char after)
     {
-        if (CB.writeMemory) {
-            CB.writeMemory(CB.arg, addr, before);
-            CB.writeMemory(CB.arg, addr, after);
-        }
+        writeBus(addr, before);
+        writeBus(addr, after);
         consumeClock();
     }
 
     inline unsigned char fetch()
     {
-        return readMemory(R.pc++);
+        unsigned char result;
+        if (isPredecode() && PD->replay) {
+            R.pc++;
+            consumeClock();
+            result = *PD->replay++;
+        } else {
+            result = readMemory(R.pc++);
+            if (isPredecode() && PD->recordEntry && PD->record.length < 3) PD->record.code[PD->record.length++] = result;
+        }
+        if (isTrace() && TR.length < 3) TR.code[TR.length++] = result;
+        return result;
+    }
+
+    // fetch a 16-bit operand (the 2 cycles are consumed at once if the clock callback is not set)
+    inline unsigned short fetch16()
+    {
+        if (!isClockCallback() && !isClockSync() && !isTrace()) {
+            if (isPredecode() && PD->replay) {
+                unsigned short result = PD->replay[0] | (PD->replay[1] << 8);
+                PD->replay += 2;
+                R.pc += 2;
+                this->clockConsumed += 2;
+                return result;
+            }
+            if (!isPredecode() || !PD->recordEntry) {
+                unsigned short result = readBus16(R.pc);
+                R.pc += 2;
+                this->clockConsumed += 2;
+                return result;
+            }
+        }
+        unsigned char low = fetch();
+        unsigned short high = fetch();
+        return (high << 8) | low;
+    }
+
+    // read a 16-bit little endian value (the 2 cycles are consumed at once if the clock callback is not set)
+    inline unsigned short readMemory16(unsigned short addr)
+    {
+        if (isClockCallback() || isClockSync()) {
+            unsigned char low = readMemory(addr);
+            unsigned short high = readMemory(addr + 1);
+            return (high << 8) | low;
+        }
+        this->clockConsumed += 2;
+        return readBus16(addr);
+    }
+
+    // access to the memory bus for a 16-bit little endian value without consuming the clock
+    // (loaded at once by the read16 of the Bus if the both bytes have no low memory, clock sync and watch point)
+    inline unsigned short readBus16(unsigned short addr)
+    {
+        unsigned short result;
+        if (M6502BusRead16<Bus>::supported && !isLowMemory(addr) && !isClockSyncAddress(addr) && !isClockSyncAddress(addr + 1) && !isWatchAddress(addr, M6502_WATCH_READ) && !isWatchAddress(addr + 1, M6502_WATCH_READ)) {
+            if (M6502BusRead16<Bus>::read(bus, addr, &result)) {
+                if (isIdleSkip() && (!isStableAddress(addr) || !isStableAddress(addr + 1))) IL.dirty = true;
+                return result;
+            }
+        }
+        unsigned char low = readBus(addr);
+        unsigned short high = readBus(addr + 1);
+        return (high << 8) | low;
     }
 
     inline unsigned char readImmediate()
     {
         unsigned short value = fetch();
-        if (CB.debugMessage) sprintf(DD.opp, "#$%02X", value);
+        if (isDebug()) sprintf(DD.opp, "#$%02X", value);
         return value;
     }
 
     inline unsigned short zeroPage()
     {
         unsigned short addr = fetch();
-        if (CB.debugMessage) sprintf(DD.opp, "$%02X", addr);
+        if (isDebug()) sprintf(DD.opp, "$%02X", addr);
+        if (isTrace()) TR.addr = addr;
         return addr;
     }
     inline unsigned char readZeroPage(unsigned short* a)
@@ -410,10 +2645,11 @@ class M6502
     inline unsigned short zeroPageX()
     {
         unsigned short addr = fetch();
-        if (CB.debugMessage) sprintf(DD.opp, "$%02X,X<$%02X>", addr, R.x);
+        if (isDebug()) sprintf(DD.opp, "$%02X,X<$%02X>", addr, R.x);
         addr += R.x;
         addr &= 0xFF;
         consumeClock();
+        if (isTrace()) TR.addr = addr;
         return addr;
     }
     inline unsigned char readZeroPageX(unsigned short* a)
@@ -426,10 +2662,11 @@ class M6502
     inline unsigned short zeroPageY()
     {
         unsigned short addr = fetch();
-        if (CB.debugMessage) sprintf(DD.opp, "$%02X,Y<$%02X>", addr, R.y);
+        if (isDebug()) sprintf(DD.opp, "$%02X,Y<$%02X>", addr, R.y);
         addr += R.y;
         addr &= 0xFF;
         consumeClock();
+        if (isTrace()) TR.addr = addr;
         return addr;
     }
     inline unsigned char readZeroPageY(unsigned short* a)
@@ -441,11 +2678,9 @@ class M6502
 
     inline unsigned short absolute()
     {
-        unsigned char low = fetch();
-        unsigned short addr = fetch();
-        addr <<= 8;
-        addr |= low;
-        if (CB.debugMessage) sprintf(DD.opp, "$%04X", addr);
+        unsigned short addr = fetch16();
+        if (isDebug()) sprintf(DD.opp, "$%04X", addr);
+        if (isTrace()) TR.addr = addr;
         return addr;
     }
     inline unsigned char readAbsolute(unsigned short* a)
@@ -457,12 +2692,10 @@ class M6502
 
     inline unsigned short absoluteX(bool alwaysPenalty)
     {
-        unsigned int low = fetch();
-        unsigned short addr = fetch();
-        addr <<= 8;
-        unsigned short dummyReadAddr = addr;
-        addr |= low;
-        if (CB.debugMessage) sprintf(DD.opp, "$%04X,X<$%02X>", addr, R.x);
+        unsigned short addr = fetch16();
+        unsigned int low = addr & 0xFF;
+        unsigned short dummyReadAddr = addr & 0xFF00;
+        if (isDebug()) sprintf(DD.opp, "$%04X,X<$%02X>", addr, R.x);
         addr += R.x;
         if (0xFF < R.x + low) {
             // consume a penalty cycle by dummy read
@@ -471,6 +2704,7 @@ class M6502
         } else if (alwaysPenalty) {
             consumeClock(); // consume a penalty cycle
         }
+        if (isTrace()) TR.addr = addr;
         return addr;
     }
     inline unsigned char readAbsoluteX(unsigned short* a, bool alwaysPenalty = false)
@@ -482,12 +2716,10 @@ class M6502
 
     inline unsigned short absoluteY(bool alwaysPenalty)
     {
-        unsigned int low = fetch();
-        unsigned short addr = fetch();
-        addr <<= 8;
-        unsigned short dummyReadAddr = addr;
-        addr |= low;
-        if (CB.debugMessage) sprintf(DD.opp, "$%04X,Y<$%02X>", addr, R.y);
+        unsigned short addr = fetch16();
+        unsigned int low = addr & 0xFF;
+        unsigned short dummyReadAddr = addr & 0xFF00;
+        if (isDebug()) sprintf(DD.opp, "$%04X,Y<$%02X>", addr, R.y);
         addr += R.y;
         if (0xFF < R.y + low) {
             // consume a penalty cycle by dummy read
@@ -496,6 +2728,7 @@ class M6502
         } else if (alwaysPenalty) {
             consumeClock(); // consume a penalty cycle
         }
+        if (isTrace()) TR.addr = addr;
         return addr;
     }
     inline unsigned char readAbsoluteY(unsigned short* a, bool alwaysPenalty = false)
@@ -508,13 +2741,14 @@ class M6502
     inline unsigned short indirectX()
     {
         unsigned char zero = fetch();
-        if (CB.debugMessage) sprintf(DD.opp, "($%02X,X<$%02X>)", zero, R.x);
+        if (isDebug()) sprintf(DD.opp, "($%02X,X<$%02X>)", zero, R.x);
         zero += R.x;
         unsigned char low = readMemory(zero++);
         unsigned short addr = readMemory(zero);
         addr <<= 8;
         addr |= low;
         consumeClock();
+        if (isTrace()) TR.addr = addr;
         return addr;
     }
     inline unsigned char readIndirectX(unsigned short* a)
@@ -527,7 +2761,7 @@ class M6502
     inline unsigned short indirectY(bool alwaysPenalty)
     {
         unsigned char zero = fetch();
-        if (CB.debugMessage) sprintf(DD.opp, "($%02X),Y<$%02X>", zero, R.y);
+        if (isDebug()) sprintf(DD.opp, "($%02X),Y<$%02X>", zero, R.y);
         unsigned int low = readMemory(zero++);
         unsigned short addr = readMemory(zero);
         addr <<= 8;
@@ -541,6 +2775,7 @@ class M6502
         } else if (alwaysPenalty) {
             consumeClock(); // consume a penalty cycle
         }
+        if (isTrace()) TR.addr = addr;
         return addr;
     }
     inline unsigned char readIndirectY(unsigned short* a, bool alwaysPenalty = false)
@@ -550,17 +2785,39 @@ class M6502
         return readMemory(addr);
     }
 
+    // update N and Z by the result of an operation
+    inline void updateStatusNZ(unsigned char value)
+    {
+        if (isLazyFlags()) {
+            lazyResult = value;
+        } else {
+            R.p = (R.p & 0b01111101) | flagTable.nz[value];
+        }
+    }
+
+    // materialize the lazy N and Z into R.p (M6502_FEATURE_LAZY_FLAGS)
+    // called before the code that observes R.p: the callbacks other than the memory bus, PHP and the interrupts
+    inline void syncStatus()
+    {
+        if (isLazyFlags() && 0 <= lazyResult) {
+            R.p = (R.p & 0b01111101) | flagTable.nz[lazyResult];
+            lazyResult = -1;
+        }
+    }
+
     inline void updateStatusN(bool n, bool consume = false)
     {
+        syncStatus();
         n ? R.p |= 0b10000000 : R.p &= 0b01111111;
         if (consume) {
             consumeClock();
-            if (CB.debugMessage) strcpy(DD.mne, n ? "SEN" : "CLN");
+            if (isDebug()) strcpy(DD.mne, n ? "SEN" : "CLN");
         }
     }
 
     inline bool getStatusN()
     {
+        if (isLazyFlags() && 0 <= lazyResult) return lazyResult & 0b10000000 ? true : false;
         return R.p & 0b10000000 ? true : false;
     }
 
@@ -569,7 +2826,7 @@ class M6502
         v ? R.p |= 0b01000000 : R.p &= 0b10111111;
         if (consume) {
             consumeClock();
-            if (CB.debugMessage) strcpy(DD.mne, v ? "SEV" : "CLV");
+            if (isDebug()) strcpy(DD.mne, v ? "SEV" : "CLV");
         }
     }
 
@@ -583,7 +2840,7 @@ class M6502
         b ? R.p |= 0b00010000 : R.p &= 0b11101111;
         if (consume) {
             consumeClock();
-            if (CB.debugMessage) strcpy(DD.mne, b ? "SEB" : "CLB");
+            if (isDebug()) strcpy(DD.mne, b ? "SEB" : "CLB");
         }
     }
 
@@ -597,7 +2854,7 @@ class M6502
         d ? R.p |= 0b00001000 : R.p &= 0b11110111;
         if (consume) {
             consumeClock();
-            if (CB.debugMessage) strcpy(DD.mne, d ? "SED" : "CLD");
+            if (isDebug()) strcpy(DD.mne, d ? "SED" : "CLD");
         }
     }
 
@@ -611,7 +2868,7 @@ class M6502
         i ? R.p |= 0b00000100 : R.p &= 0b11111011;
         if (consume) {
             consumeClock();
-            if (CB.debugMessage) strcpy(DD.mne, i ? "SEI" : "CLI");
+            if (isDebug()) strcpy(DD.mne, i ? "SEI" : "CLI");
         }
     }
 
@@ -622,15 +2879,17 @@ class M6502
 
     inline void updateStatusZ(bool z, bool consume = false)
     {
+        syncStatus();
         z ? R.p |= 0b00000010 : R.p &= 0b11111101;
         if (consume) {
             consumeClock();
-            if (CB.debugMessage) strcpy(DD.mne, z ? "SEZ" : "CLZ");
+            if (isDebug()) strcpy(DD.mne, z ? "SEZ" : "CLZ");
         }
     }
 
     inline bool getStatusZ()
     {
+        if (isLazyFlags() && 0 <= lazyResult) return 0 == lazyResult;
         return R.p & 0b00000010 ? true : false;
     }
 
@@ -639,7 +2898,7 @@ class M6502
         c ? R.p |= 0b00000001 : R.p &= 0b11111110;
         if (consume) {
             consumeClock();
-            if (CB.debugMessage) strcpy(DD.mne, c ? "SEC" : "CLC");
+            if (isDebug()) strcpy(DD.mne, c ? "SEC" : "CLC");
         }
     }
 
@@ -651,28 +2910,19 @@ class M6502
     inline void add(unsigned char value)
     {
         int result = (int)R.a + (int)value + (getStatusC() ? 1 : 0);
-        updateStatusN(result & 0x80 ? true : false);
-        updateStatusZ((result & 0xFF) == 0);
-        updateStatusV(~(R.a ^ value) & (R.a ^ result) & 0x80 ? true : false);
-        updateStatusC(0xFF < result);
+        unsigned char v = ~(R.a ^ value) & (R.a ^ result) & 0x80 ? 0b01000000 : 0;
+        R.p = (R.p & 0b10111110) | v | (0xFF < result ? 0b00000001 : 0);
+        updateStatusNZ(result & 0xFF);
         R.a = (unsigned char)result;
     }
 
     inline void adc(unsigned char value)
     {
-        if (CB.debugMessage) strcpy(DD.mne, "ADC");
+        if (isDebug()) strcpy(DD.mne, "ADC");
         if (isSupportBCD() && getStatusD()) {
-            int aH = ((R.a & 0b11110000) >> 4) % 10;
-            int aL = (R.a & 0b00001111) % 10;
-            int vH = ((value & 0b11110000) >> 4) % 10;
-            int vL = (value & 0b00001111) % 10;
-            aL += vL + (getStatusC() ? 1 : 0);
-            int halfCarry = aL / 10 ? 1 : 0;
-            aL %= 10;
-            aH += vH + halfCarry;
-            updateStatusC(aH / 10 ? true : false);
-            aH %= 10;
-            R.a = (aH << 4) + aL;
+            unsigned short result = M6502DecimalTable::calculate(M6502DecimalTable::get().adc, R.a, value, getStatusC());
+            updateStatusC(result & 0x100 ? true : false);
+            R.a = result & 0xFF;
             updateStatusZ(R.a == 0);
         } else {
             add(value);
@@ -681,24 +2931,11 @@ class M6502
 
     inline void sbc(unsigned char value)
     {
-        if (CB.debugMessage) strcpy(DD.mne, "SBC");
+        if (isDebug()) strcpy(DD.mne, "SBC");
         if (isSupportBCD() && getStatusD()) {
-            int aH = ((R.a & 0b11110000) >> 4) % 10;
-            int aL = (R.a & 0b00001111) % 10;
-            int a = aH * 10 + aL;
-            int vH = ((value & 0b11110000) >> 4) % 10;
-            int vL = (value & 0b00001111) % 10;
-            int v = vH * 10 + vL;
-            a -= v + (getStatusC() ? 0 : 1);
-            if (a < 0) {
-                a += 100;
-                updateStatusC(false);
-            } else {
-                updateStatusC(true);
-            }
-            aH = a / 10;
-            aL = a % 10;
-            R.a = (aH << 4) + aL;
+            unsigned short result = M6502DecimalTable::calculate(M6502DecimalTable::get().sbc, R.a, value, getStatusC());
+            updateStatusC(result & 0x100 ? true : false);
+            R.a = result & 0xFF;
             updateStatusZ(R.a == 0);
         } else {
             add(value ^ 0xFF); // To ones' complement (tobe two's complement, if carry is set)
@@ -707,31 +2944,28 @@ class M6502
 
     inline void and_(unsigned char value)
     {
-        if (CB.debugMessage) strcpy(DD.mne, "AND");
+        if (isDebug()) strcpy(DD.mne, "AND");
         R.a &= value;
-        updateStatusN(R.a & 0x80);
-        updateStatusZ(R.a == 0);
+        updateStatusNZ(R.a);
     }
 
     inline void ora(unsigned char value)
     {
-        if (CB.debugMessage) strcpy(DD.mne, "ORA");
+        if (isDebug()) strcpy(DD.mne, "ORA");
         R.a |= value;
-        updateStatusN(R.a & 0x80);
-        updateStatusZ(R.a == 0);
+        updateStatusNZ(R.a);
     }
 
     inline void eor(unsigned char value)
     {
-        if (CB.debugMessage) strcpy(DD.mne, "EOR");
+        if (isDebug()) strcpy(DD.mne, "EOR");
         R.a ^= value;
-        updateStatusN(R.a & 0x80);
-        updateStatusZ(R.a == 0);
+        updateStatusNZ(R.a);
     }
 
     inline void bit(unsigned char value)
     {
-        if (CB.debugMessage) strcpy(DD.mne, "BIT");
+        if (isDebug()) strcpy(DD.mne, "BIT");
         unsigned char w = R.a & value;
         updateStatusN(value & 0b10000000);
         updateStatusV(value & 0b01000000);
@@ -740,12 +2974,12 @@ class M6502
 
     inline void branch(const char* mne, bool isBranch)
     {
-        if (CB.debugMessage) strcpy(DD.mne, mne);
+        if (isDebug()) strcpy(DD.mne, mne);
         int rel = (signed char)fetch();
         if (0 == rel) {
-            if (CB.onError) CB.onError(CB.arg, M6502_ERROR_BRANCH_ZERO);
+            raiseError(M6502_ERROR_BRANCH_ZERO);
         }
-        if (CB.debugMessage) sprintf(DD.opp, "$%04X%s$%02X", R.pc, rel & 0x80 ? "-" : "+", abs(rel));
+        if (isDebug()) sprintf(DD.opp, "$%04X%s$%02X", R.pc, rel & 0x80 ? "-" : "+", abs(rel));
         if (!isBranch) return; // not branch
         if ((R.pc & 0xFF00) != ((R.pc + rel) & 0xFF00)) {
             consumeClock(); // consume a penalty cycle (page crossover)
@@ -756,9 +2990,8 @@ class M6502
 
     inline void cp(const char* mne, int m, unsigned char value)
     {
-        if (CB.debugMessage) strcpy(DD.mne, mne);
-        updateStatusN((m - value) & 0x80 ? true : false);
-        updateStatusZ(m == value);
+        if (isDebug()) strcpy(DD.mne, mne);
+        updateStatusNZ((unsigned char)(m - value));
         updateStatusC(m >= value);
     }
     inline void cmp(unsigned char value) { cp("CMP", R.a, value); }
@@ -767,10 +3000,9 @@ class M6502
 
     inline void ld(const char* mne, unsigned char* r, unsigned char value)
     {
-        if (CB.debugMessage) strcpy(DD.mne, mne);
+        if (isDebug()) strcpy(DD.mne, mne);
         *r = value;
-        updateStatusN(*r & 0x80);
-        updateStatusZ(*r == 0);
+        updateStatusNZ(*r);
     }
     inline void lda(unsigned char value) { ld("LDA", &R.a, value); }
     inline void ldx(unsigned char value) { ld("LDX", &R.x, value); }
@@ -778,7 +3010,7 @@ class M6502
 
     inline void st(const char* mne, unsigned short addr, unsigned char value)
     {
-        if (CB.debugMessage) strcpy(DD.mne, mne);
+        if (isDebug()) strcpy(DD.mne, mne);
         writeMemory(addr, value);
     }
     inline void sta(unsigned short addr) { st("STA", addr, R.a); }
@@ -792,12 +3024,16 @@ class M6502
     }
     inline void ph(const char* mne, unsigned char r)
     {
-        if (CB.debugMessage) strcpy(DD.mne, mne);
+        if (isDebug()) strcpy(DD.mne, mne);
         push(r);
         consumeClock();
     }
-    static inline void pha(M6502* cpu) { cpu->ph("PHA", cpu->R.a); }
-    static inline void php(M6502* cpu) { cpu->ph("PHP", cpu->R.p); }
+    static inline void pha(M6502T* cpu) { cpu->ph("PHA", cpu->R.a); }
+    static inline void php(M6502T* cpu)
+    {
+        cpu->syncStatus();
+        cpu->ph("PHP", cpu->R.p);
+    }
 
     inline unsigned char pull()
     {
@@ -807,66 +3043,68 @@ class M6502
     }
     inline void pl(const char* mne, unsigned char* r)
     {
-        if (CB.debugMessage) strcpy(DD.mne, mne);
+        if (isDebug()) strcpy(DD.mne, mne);
         consumeClock();
         *r = pull();
         consumeClock();
     }
-    static inline void pla(M6502* cpu) { cpu->pl("PLA", &cpu->R.a); }
-    static inline void plp(M6502* cpu) { cpu->pl("PLP", &cpu->R.p); }
+    static inline void pla(M6502T* cpu) { cpu->pl("PLA", &cpu->R.a); }
+    static inline void plp(M6502T* cpu)
+    {
+        cpu->syncStatus(); // discard the lazy N and Z before R.p is overwritten
+        cpu->pl("PLP", &cpu->R.p);
+    }
 
     inline void transfer(const char* mne, unsigned char src, unsigned char* dst, bool updateStatus)
     {
-        if (CB.debugMessage) strcpy(DD.mne, mne);
+        if (isDebug()) strcpy(DD.mne, mne);
         *dst = src;
         if (updateStatus) {
-            updateStatusN(src & 0x80);
-            updateStatusZ(src == 0);
+            updateStatusNZ(src);
         }
         consumeClock();
     }
-    static inline void tax(M6502* cpu) { cpu->transfer("TAX", cpu->R.a, &cpu->R.x, true); }
-    static inline void txa(M6502* cpu) { cpu->transfer("TXA", cpu->R.x, &cpu->R.a, true); }
-    static inline void tay(M6502* cpu) { cpu->transfer("TAY", cpu->R.a, &cpu->R.y, true); }
-    static inline void tya(M6502* cpu) { cpu->transfer("TYA", cpu->R.y, &cpu->R.a, true); }
-    static inline void tsx(M6502* cpu) { cpu->transfer("TSX", cpu->R.s, &cpu->R.x, true); }
-    static inline void txs(M6502* cpu) { cpu->transfer("TXS", cpu->R.x, &cpu->R.s, false); }
+    static inline void tax(M6502T* cpu) { cpu->transfer("TAX", cpu->R.a, &cpu->R.x, true); }
+    static inline void txa(M6502T* cpu) { cpu->transfer("TXA", cpu->R.x, &cpu->R.a, true); }
+    static inline void tay(M6502T* cpu) { cpu->transfer("TAY", cpu->R.a, &cpu->R.y, true); }
+    static inline void tya(M6502T* cpu) { cpu->transfer("TYA", cpu->R.y, &cpu->R.a, true); }
+    static inline void tsx(M6502T* cpu) { cpu->transfer("TSX", cpu->R.s, &cpu->R.x, true); }
+    static inline void txs(M6502T* cpu) { cpu->transfer("TXS", cpu->R.x, &cpu->R.s, false); }
 
     inline unsigned char asl(unsigned char value)
     {
-        if (CB.debugMessage) strcpy(DD.mne, "ASL");
+        if (isDebug()) strcpy(DD.mne, "ASL");
         int work = value;
         work <<= 1;
         unsigned char result = work & 0xFF;
-        updateStatusN(result & 0x80);
-        updateStatusZ(result == 0);
+        updateStatusNZ(result);
         updateStatusC(work & 0xFF00 ? true : false);
         consumeClock();
         return result;
     }
-    static inline void asl_a(M6502* cpu) { cpu->R.a = cpu->asl(cpu->R.a); }
-    static inline void asl_zpg(M6502* cpu)
+    static inline void asl_a(M6502T* cpu) { cpu->R.a = cpu->asl(cpu->R.a); }
+    static inline void asl_zpg(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readZeroPage(&addr);
         unsigned char after = cpu->asl(before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void asl_zpg_x(M6502* cpu)
+    static inline void asl_zpg_x(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readZeroPageX(&addr);
         unsigned char after = cpu->asl(before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void asl_abs(M6502* cpu)
+    static inline void asl_abs(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readAbsolute(&addr);
         unsigned char after = cpu->asl(before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void asl_abs_x(M6502* cpu)
+    static inline void asl_abs_x(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readAbsoluteX(&addr, true);
@@ -876,39 +3114,38 @@ class M6502
 
     inline unsigned char lsr(unsigned char value)
     {
-        if (CB.debugMessage) strcpy(DD.mne, "LSR");
-        if (CB.debugMessage && !DD.opp[0]) sprintf(DD.opp, "A<$%02X>", R.a);
+        if (isDebug()) strcpy(DD.mne, "LSR");
+        if (isDebug() && !DD.opp[0]) sprintf(DD.opp, "A<$%02X>", R.a);
         updateStatusC(value & 0x01 ? true : false);
         value &= 0xFE;
         value >>= 1;
-        updateStatusN(false);
-        updateStatusZ(value == 0);
+        updateStatusNZ(value);
         consumeClock();
         return value;
     }
-    static inline void lsr_a(M6502* cpu) { cpu->R.a = cpu->lsr(cpu->R.a); }
-    static inline void lsr_zpg(M6502* cpu)
+    static inline void lsr_a(M6502T* cpu) { cpu->R.a = cpu->lsr(cpu->R.a); }
+    static inline void lsr_zpg(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readZeroPage(&addr);
         unsigned char after = cpu->lsr(before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void lsr_zpg_x(M6502* cpu)
+    static inline void lsr_zpg_x(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readZeroPageX(&addr);
         unsigned char after = cpu->lsr(before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void lsr_abs(M6502* cpu)
+    static inline void lsr_abs(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readAbsolute(&addr);
         unsigned char after = cpu->lsr(before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void lsr_abs_x(M6502* cpu)
+    static inline void lsr_abs_x(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readAbsoluteX(&addr, true);
@@ -918,40 +3155,39 @@ class M6502
 
     inline unsigned char rol(unsigned char value)
     {
-        if (CB.debugMessage) strcpy(DD.mne, "ROL");
-        if (CB.debugMessage && !DD.opp[0]) sprintf(DD.opp, "A<$%02X>", R.a);
+        if (isDebug()) strcpy(DD.mne, "ROL");
+        if (isDebug() && !DD.opp[0]) sprintf(DD.opp, "A<$%02X>", R.a);
         updateStatusC(value & 0x80 ? true : false);
         value &= 0x7F;
         value <<= 1;
         value |= getStatusC() ? 0x01 : 0x00;
-        updateStatusN(value & 0x80 ? true : false);
-        updateStatusZ(value == 0);
+        updateStatusNZ(value);
         consumeClock();
         return value;
     }
-    static inline void rol_a(M6502* cpu) { cpu->R.a = cpu->rol(cpu->R.a); }
-    static inline void rol_zpg(M6502* cpu)
+    static inline void rol_a(M6502T* cpu) { cpu->R.a = cpu->rol(cpu->R.a); }
+    static inline void rol_zpg(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readZeroPage(&addr);
         unsigned char after = cpu->rol(before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void rol_zpg_x(M6502* cpu)
+    static inline void rol_zpg_x(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readZeroPageX(&addr);
         unsigned char after = cpu->rol(before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void rol_abs(M6502* cpu)
+    static inline void rol_abs(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readAbsolute(&addr);
         unsigned char after = cpu->rol(before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void rol_abs_x(M6502* cpu)
+    static inline void rol_abs_x(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readAbsoluteX(&addr, true);
@@ -961,40 +3197,39 @@ class M6502
 
     inline unsigned char ror(unsigned char value)
     {
-        if (CB.debugMessage) strcpy(DD.mne, "ROR");
-        if (CB.debugMessage && !DD.opp[0]) sprintf(DD.opp, "A<$%02X>", R.a);
+        if (isDebug()) strcpy(DD.mne, "ROR");
+        if (isDebug() && !DD.opp[0]) sprintf(DD.opp, "A<$%02X>", R.a);
         updateStatusC(value & 0x01 ? true : false);
         value &= 0xFE;
         value >>= 1;
         value |= getStatusC() ? 0x80 : 0x00;
-        updateStatusN(value & 0x80 ? true : false);
-        updateStatusZ(value == 0);
+        updateStatusNZ(value);
         consumeClock();
         return value;
     }
-    static inline void ror_a(M6502* cpu) { cpu->R.a = cpu->ror(cpu->R.a); }
-    static inline void ror_zpg(M6502* cpu)
+    static inline void ror_a(M6502T* cpu) { cpu->R.a = cpu->ror(cpu->R.a); }
+    static inline void ror_zpg(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readZeroPage(&addr);
         unsigned char after = cpu->ror(before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void ror_zpg_x(M6502* cpu)
+    static inline void ror_zpg_x(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readZeroPageX(&addr);
         unsigned char after = cpu->ror(before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void ror_abs(M6502* cpu)
+    static inline void ror_abs(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readAbsolute(&addr);
         unsigned char after = cpu->ror(before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void ror_abs_x(M6502* cpu)
+    static inline void ror_abs_x(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readAbsoluteX(&addr, true);
@@ -1004,127 +3239,113 @@ class M6502
 
     inline unsigned char dec(const char* mne, unsigned char value)
     {
-        if (CB.debugMessage) strcpy(DD.mne, mne);
+        if (isDebug()) strcpy(DD.mne, mne);
         value--;
-        updateStatusN(value & 0x80);
-        updateStatusZ(value == 0);
+        updateStatusNZ(value);
         consumeClock();
         return value;
     }
-    static inline void dec_zpg(M6502* cpu)
+    static inline void dec_zpg(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readZeroPage(&addr);
         unsigned char after = cpu->dec("DEC", before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void dec_zpg_x(M6502* cpu)
+    static inline void dec_zpg_x(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readZeroPageX(&addr);
         unsigned char after = cpu->dec("DEC", before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void dec_abs(M6502* cpu)
+    static inline void dec_abs(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readAbsolute(&addr);
         unsigned char after = cpu->dec("DEC", before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void dec_abs_x(M6502* cpu)
+    static inline void dec_abs_x(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readAbsoluteX(&addr, true);
         unsigned char after = cpu->dec("DEC", before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void dex(M6502* cpu) { cpu->R.x = cpu->dec("DEX", cpu->R.x); }
-    static inline void dey(M6502* cpu) { cpu->R.y = cpu->dec("DEY", cpu->R.y); }
+    static inline void dex(M6502T* cpu) { cpu->R.x = cpu->dec("DEX", cpu->R.x); }
+    static inline void dey(M6502T* cpu) { cpu->R.y = cpu->dec("DEY", cpu->R.y); }
 
     inline unsigned char inc(const char* mne, unsigned char value)
     {
-        if (CB.debugMessage) strcpy(DD.mne, mne);
+        if (isDebug()) strcpy(DD.mne, mne);
         value++;
-        updateStatusN(value & 0x80);
-        updateStatusZ(value == 0);
+        updateStatusNZ(value);
         consumeClock();
         return value;
     }
-    static inline void inc_zpg(M6502* cpu)
+    static inline void inc_zpg(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readZeroPage(&addr);
         unsigned char after = cpu->inc("INC", before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void inc_zpg_x(M6502* cpu)
+    static inline void inc_zpg_x(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readZeroPageX(&addr);
         unsigned char after = cpu->inc("INC", before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void inc_abs(M6502* cpu)
+    static inline void inc_abs(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readAbsolute(&addr);
         unsigned char after = cpu->inc("INC", before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void inc_abs_x(M6502* cpu)
+    static inline void inc_abs_x(M6502T* cpu)
     {
         unsigned short addr;
         unsigned char before = cpu->readAbsoluteX(&addr, true);
         unsigned char after = cpu->inc("INC", before);
         cpu->writeMemoryWithDummy(addr, before, after);
     }
-    static inline void inx(M6502* cpu) { cpu->R.x = cpu->inc("INX", cpu->R.x); }
-    static inline void iny(M6502* cpu) { cpu->R.y = cpu->inc("INY", cpu->R.y); }
+    static inline void inx(M6502T* cpu) { cpu->R.x = cpu->inc("INX", cpu->R.x); }
+    static inline void iny(M6502T* cpu) { cpu->R.y = cpu->inc("INY", cpu->R.y); }
 
-    static inline void jmp_abs(M6502* cpu)
+    static inline void jmp_abs(M6502T* cpu)
     {
-        if (cpu->CB.debugMessage) strcpy(cpu->DD.mne, "JMP");
-        unsigned char low = cpu->fetch();
-        unsigned short addr = cpu->fetch();
-        addr <<= 8;
-        addr |= low;
-        if (cpu->CB.debugMessage) sprintf(cpu->DD.opp, "$%04X", addr);
+        if (cpu->isDebug()) strcpy(cpu->DD.mne, "JMP");
+        unsigned short addr = cpu->fetch16();
+        if (cpu->isDebug()) sprintf(cpu->DD.opp, "$%04X", addr);
         cpu->R.pc = addr;
     }
 
-    static inline void jmp_ind(M6502* cpu)
+    static inline void jmp_ind(M6502T* cpu)
     {
-        if (cpu->CB.debugMessage) strcpy(cpu->DD.mne, "JMP");
-        unsigned char low = cpu->fetch();
-        unsigned short addr = cpu->fetch();
-        addr <<= 8;
-        addr |= low;
-        if (cpu->CB.debugMessage) sprintf(cpu->DD.opp, "($%04X)", addr);
-        low = cpu->readMemory(addr++);
-        addr = cpu->readMemory(addr);
-        addr <<= 8;
-        addr |= low;
-        cpu->R.pc = addr;
+        if (cpu->isDebug()) strcpy(cpu->DD.mne, "JMP");
+        unsigned short addr = cpu->fetch16();
+        if (cpu->isDebug()) sprintf(cpu->DD.opp, "($%04X)", addr);
+        if (cpu->isTrace()) cpu->TR.addr = addr;
+        cpu->R.pc = cpu->readMemory16(addr);
     }
 
-    static inline void jsr_abs(M6502* cpu)
+    static inline void jsr_abs(M6502T* cpu)
     {
-        if (cpu->CB.debugMessage) strcpy(cpu->DD.mne, "JSR");
-        unsigned char low = cpu->fetch();
-        unsigned short addr = cpu->fetch();
-        addr <<= 8;
-        addr |= low;
-        if (cpu->CB.debugMessage) sprintf(cpu->DD.opp, "$%04X", addr);
+        if (cpu->isDebug()) strcpy(cpu->DD.mne, "JSR");
+        unsigned short addr = cpu->fetch16();
+        if (cpu->isDebug()) sprintf(cpu->DD.opp, "$%04X", addr);
         cpu->push(cpu->R.pc & 0xFF);
         cpu->push((cpu->R.pc & 0xFF00) >> 8);
         cpu->R.pc = addr;
         cpu->consumeClock();
     }
 
-    static inline void rts(M6502* cpu)
+    static inline void rts(M6502T* cpu)
     {
-        if (cpu->CB.debugMessage) strcpy(cpu->DD.mne, "RTS");
+        if (cpu->isDebug()) strcpy(cpu->DD.mne, "RTS");
         unsigned short addr = cpu->pull();
         unsigned char low = cpu->pull();
         addr <<= 8;
@@ -1135,16 +3356,17 @@ class M6502
         cpu->consumeClock();
     }
 
-    static inline void brk(M6502* cpu)
+    static inline void brk(M6502T* cpu)
     {
-        if (cpu->CB.debugMessage) strcpy(cpu->DD.mne, "BRK");
+        if (cpu->isDebug()) strcpy(cpu->DD.mne, "BRK");
         cpu->fetch(); // read boundary
         cpu->executeInterrupt(0xFFFE, true);
     }
 
-    static inline void rti(M6502* cpu)
+    static inline void rti(M6502T* cpu)
     {
-        if (cpu->CB.debugMessage) strcpy(cpu->DD.mne, "RTI");
+        if (cpu->isDebug()) strcpy(cpu->DD.mne, "RTI");
+        cpu->syncStatus(); // discard the lazy N and Z before R.p is overwritten
         cpu->R.p = cpu->pull();
         unsigned char pcL = cpu->pull();
         unsigned char pcH = cpu->pull();
@@ -1155,298 +3377,336 @@ class M6502
         cpu->consumeClock();
     }
 
-    static inline void nop(M6502* cpu)
+    static inline void nop(M6502T* cpu)
     {
-        if (cpu->CB.debugMessage) strcpy(cpu->DD.mne, "NOP");
+        if (cpu->isDebug()) strcpy(cpu->DD.mne, "NOP");
         cpu->consumeClock();
     }
 
-    static inline void adc_imm(M6502* cpu) { cpu->adc(cpu->readImmediate()); }
-    static inline void adc_zpg(M6502* cpu) { cpu->adc(cpu->readZeroPage(NULL)); }
-    static inline void adc_zpg_x(M6502* cpu) { cpu->adc(cpu->readZeroPageX(NULL)); }
-    static inline void adc_abs(M6502* cpu) { cpu->adc(cpu->readAbsolute(NULL)); }
-    static inline void adc_abs_x(M6502* cpu) { cpu->adc(cpu->readAbsoluteX(NULL)); }
-    static inline void adc_abs_y(M6502* cpu) { cpu->adc(cpu->readAbsoluteY(NULL)); }
-    static inline void adc_x_ind(M6502* cpu) { cpu->adc(cpu->readIndirectX(NULL)); }
-    static inline void adc_ind_y(M6502* cpu) { cpu->adc(cpu->readIndirectY(NULL)); }
-    static inline void sbc_imm(M6502* cpu) { cpu->sbc(cpu->readImmediate()); }
-    static inline void sbc_zpg(M6502* cpu) { cpu->sbc(cpu->readZeroPage(NULL)); }
-    static inline void sbc_zpg_x(M6502* cpu) { cpu->sbc(cpu->readZeroPageX(NULL)); }
-    static inline void sbc_abs(M6502* cpu) { cpu->sbc(cpu->readAbsolute(NULL)); }
-    static inline void sbc_abs_x(M6502* cpu) { cpu->sbc(cpu->readAbsoluteX(NULL)); }
-    static inline void sbc_abs_y(M6502* cpu) { cpu->sbc(cpu->readAbsoluteY(NULL)); }
-    static inline void sbc_x_ind(M6502* cpu) { cpu->sbc(cpu->readIndirectX(NULL)); }
-    static inline void sbc_ind_y(M6502* cpu) { cpu->sbc(cpu->readIndirectY(NULL)); }
-    static inline void and_imm(M6502* cpu) { cpu->and_(cpu->readImmediate()); }
-    static inline void and_zpg(M6502* cpu) { cpu->and_(cpu->readZeroPage(NULL)); }
-    static inline void and_zpg_x(M6502* cpu) { cpu->and_(cpu->readZeroPageX(NULL)); }
-    static inline void and_abs(M6502* cpu) { cpu->and_(cpu->readAbsolute(NULL)); }
-    static inline void and_abs_x(M6502* cpu) { cpu->and_(cpu->readAbsoluteX(NULL)); }
-    static inline void and_abs_y(M6502* cpu) { cpu->and_(cpu->readAbsoluteY(NULL)); }
-    static inline void and_x_ind(M6502* cpu) { cpu->and_(cpu->readIndirectX(NULL)); }
-    static inline void and_ind_y(M6502* cpu) { cpu->and_(cpu->readIndirectY(NULL)); }
-    static inline void bmi_rel(M6502* cpu) { cpu->branch("BMI", cpu->getStatusN()); }
-    static inline void bpl_rel(M6502* cpu) { cpu->branch("BPL", !cpu->getStatusN()); }
-    static inline void bvs_rel(M6502* cpu) { cpu->branch("BVS", cpu->getStatusV()); }
-    static inline void bvc_rel(M6502* cpu) { cpu->branch("BVC", !cpu->getStatusV()); }
-    static inline void beq_rel(M6502* cpu) { cpu->branch("BEQ", cpu->getStatusZ()); }
-    static inline void bne_rel(M6502* cpu) { cpu->branch("BNE", !cpu->getStatusZ()); }
-    static inline void bcs_rel(M6502* cpu) { cpu->branch("BCS", cpu->getStatusC()); }
-    static inline void bcc_rel(M6502* cpu) { cpu->branch("BCC", !cpu->getStatusC()); }
-    static inline void bit_zpg(M6502* cpu) { cpu->bit(cpu->readZeroPage(NULL)); }
-    static inline void bit_abs(M6502* cpu) { cpu->bit(cpu->readAbsolute(NULL)); }
-    static inline void cmp_imm(M6502* cpu) { cpu->cmp(cpu->readImmediate()); }
-    static inline void cmp_zpg(M6502* cpu) { cpu->cmp(cpu->readZeroPage(NULL)); }
-    static inline void cmp_zpg_x(M6502* cpu) { cpu->cmp(cpu->readZeroPageX(NULL)); }
-    static inline void cmp_abs(M6502* cpu) { cpu->cmp(cpu->readAbsolute(NULL)); }
-    static inline void cmp_abs_x(M6502* cpu) { cpu->cmp(cpu->readAbsoluteX(NULL)); }
-    static inline void cmp_abs_y(M6502* cpu) { cpu->cmp(cpu->readAbsoluteY(NULL)); }
-    static inline void cmp_x_ind(M6502* cpu) { cpu->cmp(cpu->readIndirectX(NULL)); }
-    static inline void cmp_ind_y(M6502* cpu) { cpu->cmp(cpu->readIndirectY(NULL)); }
-    static inline void cpx_imm(M6502* cpu) { cpu->cpx(cpu->readImmediate()); }
-    static inline void cpx_zpg(M6502* cpu) { cpu->cpx(cpu->readZeroPage(NULL)); }
-    static inline void cpx_abs(M6502* cpu) { cpu->cpx(cpu->readAbsolute(NULL)); }
-    static inline void cpy_imm(M6502* cpu) { cpu->cpy(cpu->readImmediate()); }
-    static inline void cpy_zpg(M6502* cpu) { cpu->cpy(cpu->readZeroPage(NULL)); }
-    static inline void cpy_abs(M6502* cpu) { cpu->cpy(cpu->readAbsolute(NULL)); }
-    static inline void eor_imm(M6502* cpu) { cpu->eor(cpu->readImmediate()); }
-    static inline void eor_zpg(M6502* cpu) { cpu->eor(cpu->readZeroPage(NULL)); }
-    static inline void eor_zpg_x(M6502* cpu) { cpu->eor(cpu->readZeroPageX(NULL)); }
-    static inline void eor_abs(M6502* cpu) { cpu->eor(cpu->readAbsolute(NULL)); }
-    static inline void eor_abs_x(M6502* cpu) { cpu->eor(cpu->readAbsoluteX(NULL)); }
-    static inline void eor_abs_y(M6502* cpu) { cpu->eor(cpu->readAbsoluteY(NULL)); }
-    static inline void eor_x_ind(M6502* cpu) { cpu->eor(cpu->readIndirectX(NULL)); }
-    static inline void eor_ind_y(M6502* cpu) { cpu->eor(cpu->readIndirectY(NULL)); }
-    static inline void lda_imm(M6502* cpu) { cpu->lda(cpu->readImmediate()); }
-    static inline void lda_zpg(M6502* cpu) { cpu->lda(cpu->readZeroPage(NULL)); }
-    static inline void lda_zpg_x(M6502* cpu) { cpu->lda(cpu->readZeroPageX(NULL)); }
-    static inline void lda_abs(M6502* cpu) { cpu->lda(cpu->readAbsolute(NULL)); }
-    static inline void lda_abs_x(M6502* cpu) { cpu->lda(cpu->readAbsoluteX(NULL)); }
-    static inline void lda_abs_y(M6502* cpu) { cpu->lda(cpu->readAbsoluteY(NULL)); }
-    static inline void lda_x_ind(M6502* cpu) { cpu->lda(cpu->readIndirectX(NULL)); }
-    static inline void lda_ind_y(M6502* cpu) { cpu->lda(cpu->readIndirectY(NULL)); }
-    static inline void ldx_imm(M6502* cpu) { cpu->ldx(cpu->readImmediate()); }
-    static inline void ldx_zpg(M6502* cpu) { cpu->ldx(cpu->readZeroPage(NULL)); }
-    static inline void ldx_zpg_y(M6502* cpu) { cpu->ldx(cpu->readZeroPageY(NULL)); }
-    static inline void ldx_abs(M6502* cpu) { cpu->ldx(cpu->readAbsolute(NULL)); }
-    static inline void ldx_abs_y(M6502* cpu) { cpu->ldx(cpu->readAbsoluteY(NULL)); }
-    static inline void ldy_imm(M6502* cpu) { cpu->ldy(cpu->readImmediate()); }
-    static inline void ldy_zpg(M6502* cpu) { cpu->ldy(cpu->readZeroPage(NULL)); }
-    static inline void ldy_zpg_x(M6502* cpu) { cpu->ldy(cpu->readZeroPageX(NULL)); }
-    static inline void ldy_abs(M6502* cpu) { cpu->ldy(cpu->readAbsolute(NULL)); }
-    static inline void ldy_abs_x(M6502* cpu) { cpu->ldy(cpu->readAbsoluteX(NULL)); }
-    static inline void sta_zpg(M6502* cpu) { cpu->sta(cpu->zeroPage()); }
-    static inline void sta_zpg_x(M6502* cpu) { cpu->sta(cpu->zeroPageX()); }
-    static inline void sta_abs(M6502* cpu) { cpu->sta(cpu->absolute()); }
-    static inline void sta_abs_x(M6502* cpu) { cpu->sta(cpu->absoluteX(true)); }
-    static inline void sta_abs_y(M6502* cpu) { cpu->sta(cpu->absoluteY(true)); }
-    static inline void sta_x_ind(M6502* cpu) { cpu->sta(cpu->indirectX()); }
-    static inline void sta_ind_y(M6502* cpu) { cpu->sta(cpu->indirectY(true)); }
-    static inline void stx_zpg(M6502* cpu) { cpu->stx(cpu->zeroPage()); }
-    static inline void stx_zpg_y(M6502* cpu) { cpu->stx(cpu->zeroPageY()); }
-    static inline void stx_abs(M6502* cpu) { cpu->stx(cpu->absolute()); }
-    static inline void sty_zpg(M6502* cpu) { cpu->sty(cpu->zeroPage()); }
-    static inline void sty_zpg_x(M6502* cpu) { cpu->sty(cpu->zeroPageX()); }
-    static inline void sty_abs(M6502* cpu) { cpu->sty(cpu->absolute()); }
-    static inline void ora_imm(M6502* cpu) { cpu->ora(cpu->readImmediate()); }
-    static inline void ora_zpg(M6502* cpu) { cpu->ora(cpu->readZeroPage(NULL)); }
-    static inline void ora_zpg_x(M6502* cpu) { cpu->ora(cpu->readZeroPageX(NULL)); }
-    static inline void ora_abs(M6502* cpu) { cpu->ora(cpu->readAbsolute(NULL)); }
-    static inline void ora_abs_x(M6502* cpu) { cpu->ora(cpu->readAbsoluteX(NULL)); }
-    static inline void ora_abs_y(M6502* cpu) { cpu->ora(cpu->readAbsoluteY(NULL)); }
-    static inline void ora_x_ind(M6502* cpu) { cpu->ora(cpu->readIndirectX(NULL)); }
-    static inline void ora_ind_y(M6502* cpu) { cpu->ora(cpu->readIndirectY(NULL)); }
-    static inline void clc(M6502* cpu) { cpu->updateStatusC(false, true); }
-    static inline void cld(M6502* cpu) { cpu->updateStatusD(false, true); }
-    static inline void cli(M6502* cpu) { cpu->updateStatusI(false, true); }
-    static inline void clv(M6502* cpu) { cpu->updateStatusV(false, true); }
-    static inline void sec(M6502* cpu) { cpu->updateStatusC(true, true); }
-    static inline void sed(M6502* cpu) { cpu->updateStatusD(true, true); }
-    static inline void sei(M6502* cpu) { cpu->updateStatusI(true, true); }
-
-    void setupOperands()
-    {
-        memset(operands, 0, sizeof(operands));
-        operands[0xA9] = lda_imm;
-        operands[0xA5] = lda_zpg;
-        operands[0xB5] = lda_zpg_x;
-        operands[0xAD] = lda_abs;
-        operands[0xBD] = lda_abs_x;
-        operands[0xB9] = lda_abs_y;
-        operands[0xA1] = lda_x_ind;
-        operands[0xB1] = lda_ind_y;
-
-        operands[0xA2] = ldx_imm;
-        operands[0xA6] = ldx_zpg;
-        operands[0xB6] = ldx_zpg_y;
-        operands[0xAE] = ldx_abs;
-        operands[0xBE] = ldx_abs_y;
-
-        operands[0xA0] = ldy_imm;
-        operands[0xA4] = ldy_zpg;
-        operands[0xB4] = ldy_zpg_x;
-        operands[0xAC] = ldy_abs;
-        operands[0xBC] = ldy_abs_x;
-
-        operands[0x85] = sta_zpg;
-        operands[0x95] = sta_zpg_x;
-        operands[0x8D] = sta_abs;
-        operands[0x9D] = sta_abs_x;
-        operands[0x99] = sta_abs_y;
-        operands[0x81] = sta_x_ind;
-        operands[0x91] = sta_ind_y;
-
-        operands[0x86] = stx_zpg;
-        operands[0x96] = stx_zpg_y;
-        operands[0x8E] = stx_abs;
-
-        operands[0x84] = sty_zpg;
-        operands[0x94] = sty_zpg_x;
-        operands[0x8C] = sty_abs;
-
-        operands[0x69] = adc_imm;
-        operands[0x65] = adc_zpg;
-        operands[0x75] = adc_zpg_x;
-        operands[0x6D] = adc_abs;
-        operands[0x7D] = adc_abs_x;
-        operands[0x79] = adc_abs_y;
-        operands[0x61] = adc_x_ind;
-        operands[0x71] = adc_ind_y;
-
-        operands[0xE9] = sbc_imm;
-        operands[0xE5] = sbc_zpg;
-        operands[0xF5] = sbc_zpg_x;
-        operands[0xED] = sbc_abs;
-        operands[0xFD] = sbc_abs_x;
-        operands[0xF9] = sbc_abs_y;
-        operands[0xE1] = sbc_x_ind;
-        operands[0xF1] = sbc_ind_y;
-
-        operands[0x29] = and_imm;
-        operands[0x25] = and_zpg;
-        operands[0x35] = and_zpg_x;
-        operands[0x2D] = and_abs;
-        operands[0x3D] = and_abs_x;
-        operands[0x39] = and_abs_y;
-        operands[0x21] = and_x_ind;
-        operands[0x31] = and_ind_y;
-
-        operands[0x09] = ora_imm;
-        operands[0x05] = ora_zpg;
-        operands[0x15] = ora_zpg_x;
-        operands[0x0D] = ora_abs;
-        operands[0x1D] = ora_abs_x;
-        operands[0x19] = ora_abs_y;
-        operands[0x01] = ora_x_ind;
-        operands[0x11] = ora_ind_y;
-
-        operands[0x49] = eor_imm;
-        operands[0x45] = eor_zpg;
-        operands[0x55] = eor_zpg_x;
-        operands[0x4D] = eor_abs;
-        operands[0x5D] = eor_abs_x;
-        operands[0x59] = eor_abs_y;
-        operands[0x41] = eor_x_ind;
-        operands[0x51] = eor_ind_y;
-
-        operands[0xC9] = cmp_imm;
-        operands[0xC5] = cmp_zpg;
-        operands[0xD5] = cmp_zpg_x;
-        operands[0xCD] = cmp_abs;
-        operands[0xDD] = cmp_abs_x;
-        operands[0xD9] = cmp_abs_y;
-        operands[0xC1] = cmp_x_ind;
-        operands[0xD1] = cmp_ind_y;
-
-        operands[0xE0] = cpx_imm;
-        operands[0xE4] = cpx_zpg;
-        operands[0xEC] = cpx_abs;
-
-        operands[0xC0] = cpy_imm;
-        operands[0xC4] = cpy_zpg;
-        operands[0xCC] = cpy_abs;
-
-        operands[0x48] = pha;
-        operands[0x08] = php;
-        operands[0x68] = pla;
-        operands[0x28] = plp;
-
-        operands[0xAA] = tax;
-        operands[0x8A] = txa;
-        operands[0xA8] = tay;
-        operands[0x98] = tya;
-        operands[0xBA] = tsx;
-        operands[0x9A] = txs;
-
-        operands[0x0A] = asl_a;
-        operands[0x06] = asl_zpg;
-        operands[0x16] = asl_zpg_x;
-        operands[0x0E] = asl_abs;
-        operands[0x1E] = asl_abs_x;
-
-        operands[0x4A] = lsr_a;
-        operands[0x46] = lsr_zpg;
-        operands[0x56] = lsr_zpg_x;
-        operands[0x4E] = lsr_abs;
-        operands[0x5E] = lsr_abs_x;
-
-        operands[0x2A] = rol_a;
-        operands[0x26] = rol_zpg;
-        operands[0x36] = rol_zpg_x;
-        operands[0x2E] = rol_abs;
-        operands[0x3E] = rol_abs_x;
-
-        operands[0x6A] = ror_a;
-        operands[0x66] = ror_zpg;
-        operands[0x76] = ror_zpg_x;
-        operands[0x6E] = ror_abs;
-        operands[0x7E] = ror_abs_x;
-
-        operands[0xC6] = dec_zpg;
-        operands[0xD6] = dec_zpg_x;
-        operands[0xCE] = dec_abs;
-        operands[0xDE] = dec_abs_x;
-        operands[0xCA] = dex;
-        operands[0x88] = dey;
-
-        operands[0xE6] = inc_zpg;
-        operands[0xF6] = inc_zpg_x;
-        operands[0xEE] = inc_abs;
-        operands[0xFE] = inc_abs_x;
-        operands[0xE8] = inx;
-        operands[0xC8] = iny;
-
-        operands[0x24] = bit_zpg;
-        operands[0x2C] = bit_abs;
-
-        operands[0x18] = clc;
-        operands[0x58] = cli;
-        operands[0xB8] = clv;
-        operands[0x38] = sec;
-        operands[0x78] = sei;
-
-        if (isSupportBCD()) {
-            operands[0xD8] = cld;
-            operands[0xF8] = sed;
-        }
-
-        operands[0x10] = bpl_rel;
-        operands[0x30] = bmi_rel;
-        operands[0x50] = bvc_rel;
-        operands[0x70] = bvs_rel;
-        operands[0x90] = bcc_rel;
-        operands[0xB0] = bcs_rel;
-        operands[0xD0] = bne_rel;
-        operands[0xF0] = beq_rel;
-
-        operands[0x4C] = jmp_abs;
-        operands[0x6C] = jmp_ind;
-        operands[0x20] = jsr_abs;
-        operands[0x60] = rts;
-        operands[0x00] = brk;
-        operands[0x40] = rti;
-
-        operands[0xEA] = nop;
+    static inline void adc_imm(M6502T* cpu) { cpu->adc(cpu->readImmediate()); }
+    static inline void adc_zpg(M6502T* cpu) { cpu->adc(cpu->readZeroPage(NULL)); }
+    static inline void adc_zpg_x(M6502T* cpu) { cpu->adc(cpu->readZeroPageX(NULL)); }
+    static inline void adc_abs(M6502T* cpu) { cpu->adc(cpu->readAbsolute(NULL)); }
+    static inline void adc_abs_x(M6502T* cpu) { cpu->adc(cpu->readAbsoluteX(NULL)); }
+    static inline void adc_abs_y(M6502T* cpu) { cpu->adc(cpu->readAbsoluteY(NULL)); }
+    static inline void adc_x_ind(M6502T* cpu) { cpu->adc(cpu->readIndirectX(NULL)); }
+    static inline void adc_ind_y(M6502T* cpu) { cpu->adc(cpu->readIndirectY(NULL)); }
+    static inline void sbc_imm(M6502T* cpu) { cpu->sbc(cpu->readImmediate()); }
+    static inline void sbc_zpg(M6502T* cpu) { cpu->sbc(cpu->readZeroPage(NULL)); }
+    static inline void sbc_zpg_x(M6502T* cpu) { cpu->sbc(cpu->readZeroPageX(NULL)); }
+    static inline void sbc_abs(M6502T* cpu) { cpu->sbc(cpu->readAbsolute(NULL)); }
+    static inline void sbc_abs_x(M6502T* cpu) { cpu->sbc(cpu->readAbsoluteX(NULL)); }
+    static inline void sbc_abs_y(M6502T* cpu) { cpu->sbc(cpu->readAbsoluteY(NULL)); }
+    static inline void sbc_x_ind(M6502T* cpu) { cpu->sbc(cpu->readIndirectX(NULL)); }
+    static inline void sbc_ind_y(M6502T* cpu) { cpu->sbc(cpu->readIndirectY(NULL)); }
+    static inline void and_imm(M6502T* cpu) { cpu->and_(cpu->readImmediate()); }
+    static inline void and_zpg(M6502T* cpu) { cpu->and_(cpu->readZeroPage(NULL)); }
+    static inline void and_zpg_x(M6502T* cpu) { cpu->and_(cpu->readZeroPageX(NULL)); }
+    static inline void and_abs(M6502T* cpu) { cpu->and_(cpu->readAbsolute(NULL)); }
+    static inline void and_abs_x(M6502T* cpu) { cpu->and_(cpu->readAbsoluteX(NULL)); }
+    static inline void and_abs_y(M6502T* cpu) { cpu->and_(cpu->readAbsoluteY(NULL)); }
+    static inline void and_x_ind(M6502T* cpu) { cpu->and_(cpu->readIndirectX(NULL)); }
+    static inline void and_ind_y(M6502T* cpu) { cpu->and_(cpu->readIndirectY(NULL)); }
+    static inline void bmi_rel(M6502T* cpu) { cpu->branch("BMI", cpu->getStatusN()); }
+    static inline void bpl_rel(M6502T* cpu) { cpu->branch("BPL", !cpu->getStatusN()); }
+    static inline void bvs_rel(M6502T* cpu) { cpu->branch("BVS", cpu->getStatusV()); }
+    static inline void bvc_rel(M6502T* cpu) { cpu->branch("BVC", !cpu->getStatusV()); }
+    static inline void beq_rel(M6502T* cpu) { cpu->branch("BEQ", cpu->getStatusZ()); }
+    static inline void bne_rel(M6502T* cpu) { cpu->branch("BNE", !cpu->getStatusZ()); }
+    static inline void bcs_rel(M6502T* cpu) { cpu->branch("BCS", cpu->getStatusC()); }
+    static inline void bcc_rel(M6502T* cpu) { cpu->branch("BCC", !cpu->getStatusC()); }
+    static inline void bit_zpg(M6502T* cpu) { cpu->bit(cpu->readZeroPage(NULL)); }
+    static inline void bit_abs(M6502T* cpu) { cpu->bit(cpu->readAbsolute(NULL)); }
+    static inline void cmp_imm(M6502T* cpu) { cpu->cmp(cpu->readImmediate()); }
+    static inline void cmp_zpg(M6502T* cpu) { cpu->cmp(cpu->readZeroPage(NULL)); }
+    static inline void cmp_zpg_x(M6502T* cpu) { cpu->cmp(cpu->readZeroPageX(NULL)); }
+    static inline void cmp_abs(M6502T* cpu) { cpu->cmp(cpu->readAbsolute(NULL)); }
+    static inline void cmp_abs_x(M6502T* cpu) { cpu->cmp(cpu->readAbsoluteX(NULL)); }
+    static inline void cmp_abs_y(M6502T* cpu) { cpu->cmp(cpu->readAbsoluteY(NULL)); }
+    static inline void cmp_x_ind(M6502T* cpu) { cpu->cmp(cpu->readIndirectX(NULL)); }
+    static inline void cmp_ind_y(M6502T* cpu) { cpu->cmp(cpu->readIndirectY(NULL)); }
+    static inline void cpx_imm(M6502T* cpu) { cpu->cpx(cpu->readImmediate()); }
+    static inline void cpx_zpg(M6502T* cpu) { cpu->cpx(cpu->readZeroPage(NULL)); }
+    static inline void cpx_abs(M6502T* cpu) { cpu->cpx(cpu->readAbsolute(NULL)); }
+    static inline void cpy_imm(M6502T* cpu) { cpu->cpy(cpu->readImmediate()); }
+    static inline void cpy_zpg(M6502T* cpu) { cpu->cpy(cpu->readZeroPage(NULL)); }
+    static inline void cpy_abs(M6502T* cpu) { cpu->cpy(cpu->readAbsolute(NULL)); }
+    static inline void eor_imm(M6502T* cpu) { cpu->eor(cpu->readImmediate()); }
+    static inline void eor_zpg(M6502T* cpu) { cpu->eor(cpu->readZeroPage(NULL)); }
+    static inline void eor_zpg_x(M6502T* cpu) { cpu->eor(cpu->readZeroPageX(NULL)); }
+    static inline void eor_abs(M6502T* cpu) { cpu->eor(cpu->readAbsolute(NULL)); }
+    static inline void eor_abs_x(M6502T* cpu) { cpu->eor(cpu->readAbsoluteX(NULL)); }
+    static inline void eor_abs_y(M6502T* cpu) { cpu->eor(cpu->readAbsoluteY(NULL)); }
+    static inline void eor_x_ind(M6502T* cpu) { cpu->eor(cpu->readIndirectX(NULL)); }
+    static inline void eor_ind_y(M6502T* cpu) { cpu->eor(cpu->readIndirectY(NULL)); }
+    static inline void lda_imm(M6502T* cpu) { cpu->lda(cpu->readImmediate()); }
+    static inline void lda_zpg(M6502T* cpu) { cpu->lda(cpu->readZeroPage(NULL)); }
+    static inline void lda_zpg_x(M6502T* cpu) { cpu->lda(cpu->readZeroPageX(NULL)); }
+    static inline void lda_abs(M6502T* cpu) { cpu->lda(cpu->readAbsolute(NULL)); }
+    static inline void lda_abs_x(M6502T* cpu) { cpu->lda(cpu->readAbsoluteX(NULL)); }
+    static inline void lda_abs_y(M6502T* cpu) { cpu->lda(cpu->readAbsoluteY(NULL)); }
+    static inline void lda_x_ind(M6502T* cpu) { cpu->lda(cpu->readIndirectX(NULL)); }
+    static inline void lda_ind_y(M6502T* cpu) { cpu->lda(cpu->readIndirectY(NULL)); }
+    static inline void ldx_imm(M6502T* cpu) { cpu->ldx(cpu->readImmediate()); }
+    static inline void ldx_zpg(M6502T* cpu) { cpu->ldx(cpu->readZeroPage(NULL)); }
+    static inline void ldx_zpg_y(M6502T* cpu) { cpu->ldx(cpu->readZeroPageY(NULL)); }
+    static inline void ldx_abs(M6502T* cpu) { cpu->ldx(cpu->readAbsolute(NULL)); }
+    static inline void ldx_abs_y(M6502T* cpu) { cpu->ldx(cpu->readAbsoluteY(NULL)); }
+    static inline void ldy_imm(M6502T* cpu) { cpu->ldy(cpu->readImmediate()); }
+    static inline void ldy_zpg(M6502T* cpu) { cpu->ldy(cpu->readZeroPage(NULL)); }
+    static inline void ldy_zpg_x(M6502T* cpu) { cpu->ldy(cpu->readZeroPageX(NULL)); }
+    static inline void ldy_abs(M6502T* cpu) { cpu->ldy(cpu->readAbsolute(NULL)); }
+    static inline void ldy_abs_x(M6502T* cpu) { cpu->ldy(cpu->readAbsoluteX(NULL)); }
+    static inline void sta_zpg(M6502T* cpu) { cpu->sta(cpu->zeroPage()); }
+    static inline void sta_zpg_x(M6502T* cpu) { cpu->sta(cpu->zeroPageX()); }
+    static inline void sta_abs(M6502T* cpu) { cpu->sta(cpu->absolute()); }
+    static inline void sta_abs_x(M6502T* cpu) { cpu->sta(cpu->absoluteX(true)); }
+    static inline void sta_abs_y(M6502T* cpu) { cpu->sta(cpu->absoluteY(true)); }
+    static inline void sta_x_ind(M6502T* cpu) { cpu->sta(cpu->indirectX()); }
+    static inline void sta_ind_y(M6502T* cpu) { cpu->sta(cpu->indirectY(true)); }
+    static inline void stx_zpg(M6502T* cpu) { cpu->stx(cpu->zeroPage()); }
+    static inline void stx_zpg_y(M6502T* cpu) { cpu->stx(cpu->zeroPageY()); }
+    static inline void stx_abs(M6502T* cpu) { cpu->stx(cpu->absolute()); }
+    static inline void sty_zpg(M6502T* cpu) { cpu->sty(cpu->zeroPage()); }
+    static inline void sty_zpg_x(M6502T* cpu) { cpu->sty(cpu->zeroPageX()); }
+    static inline void sty_abs(M6502T* cpu) { cpu->sty(cpu->absolute()); }
+    static inline void ora_imm(M6502T* cpu) { cpu->ora(cpu->readImmediate()); }
+    static inline void ora_zpg(M6502T* cpu) { cpu->ora(cpu->readZeroPage(NULL)); }
+    static inline void ora_zpg_x(M6502T* cpu) { cpu->ora(cpu->readZeroPageX(NULL)); }
+    static inline void ora_abs(M6502T* cpu) { cpu->ora(cpu->readAbsolute(NULL)); }
+    static inline void ora_abs_x(M6502T* cpu) { cpu->ora(cpu->readAbsoluteX(NULL)); }
+    static inline void ora_abs_y(M6502T* cpu) { cpu->ora(cpu->readAbsoluteY(NULL)); }
+    static inline void ora_x_ind(M6502T* cpu) { cpu->ora(cpu->readIndirectX(NULL)); }
+    static inline void ora_ind_y(M6502T* cpu) { cpu->ora(cpu->readIndirectY(NULL)); }
+    static inline void clc(M6502T* cpu) { cpu->updateStatusC(false, true); }
+    static inline void cld(M6502T* cpu) { cpu->updateStatusD(false, true); }
+    static inline void cli(M6502T* cpu) { cpu->updateStatusI(false, true); }
+    static inline void clv(M6502T* cpu) { cpu->updateStatusV(false, true); }
+    static inline void sec(M6502T* cpu) { cpu->updateStatusC(true, true); }
+    static inline void sed(M6502T* cpu) { cpu->updateStatusD(true, true); }
+    static inline void sei(M6502T* cpu) { cpu->updateStatusI(true, true); }
+
+    static constexpr FlagTable makeFlagTable()
+    {
+        FlagTable t = {};
+        for (int i = 0; i < 256; i++) {
+            t.nz[i] = (unsigned char)((i & 0b10000000) | (i ? 0 : 0b00000010));
+        }
+        return t;
+    }
+
+    static constexpr OperandTable makeOperandTable(bool supportBCD)
+    {
+        OperandTable t = {};
+        t.operands[0xA9] = lda_imm;
+        t.operands[0xA5] = lda_zpg;
+        t.operands[0xB5] = lda_zpg_x;
+        t.operands[0xAD] = lda_abs;
+        t.operands[0xBD] = lda_abs_x;
+        t.operands[0xB9] = lda_abs_y;
+        t.operands[0xA1] = lda_x_ind;
+        t.operands[0xB1] = lda_ind_y;
+
+        t.operands[0xA2] = ldx_imm;
+        t.operands[0xA6] = ldx_zpg;
+        t.operands[0xB6] = ldx_zpg_y;
+        t.operands[0xAE] = ldx_abs;
+        t.operands[0xBE] = ldx_abs_y;
+
+        t.operands[0xA0] = ldy_imm;
+        t.operands[0xA4] = ldy_zpg;
+        t.operands[0xB4] = ldy_zpg_x;
+        t.operands[0xAC] = ldy_abs;
+        t.operands[0xBC] = ldy_abs_x;
+
+        t.operands[0x85] = sta_zpg;
+        t.operands[0x95] = sta_zpg_x;
+        t.operands[0x8D] = sta_abs;
+        t.operands[0x9D] = sta_abs_x;
+        t.operands[0x99] = sta_abs_y;
+        t.operands[0x81] = sta_x_ind;
+        t.operands[0x91] = sta_ind_y;
+
+        t.operands[0x86] = stx_zpg;
+        t.operands[0x96] = stx_zpg_y;
+        t.operands[0x8E] = stx_abs;
+
+        t.operands[0x84] = sty_zpg;
+        t.operands[0x94] = sty_zpg_x;
+        t.operands[0x8C] = sty_abs;
+
+        t.operands[0x69] = adc_imm;
+        t.operands[0x65] = adc_zpg;
+        t.operands[0x75] = adc_zpg_x;
+        t.operands[0x6D] = adc_abs;
+        t.operands[0x7D] = adc_abs_x;
+        t.operands[0x79] = adc_abs_y;
+        t.operands[0x61] = adc_x_ind;
+        t.operands[0x71] = adc_ind_y;
+
+        t.operands[0xE9] = sbc_imm;
+        t.operands[0xE5] = sbc_zpg;
+        t.operands[0xF5] = sbc_zpg_x;
+        t.operands[0xED] = sbc_abs;
+        t.operands[0xFD] = sbc_abs_x;
+        t.operands[0xF9] = sbc_abs_y;
+        t.operands[0xE1] = sbc_x_ind;
+        t.operands[0xF1] = sbc_ind_y;
+
+        t.operands[0x29] = and_imm;
+        t.operands[0x25] = and_zpg;
+        t.operands[0x35] = and_zpg_x;
+        t.operands[0x2D] = and_abs;
+        t.operands[0x3D] = and_abs_x;
+        t.operands[0x39] = and_abs_y;
+        t.operands[0x21] = and_x_ind;
+        t.operands[0x31] = and_ind_y;
+
+        t.operands[0x09] = ora_imm;
+        t.operands[0x05] = ora_zpg;
+        t.operands[0x15] = ora_zpg_x;
+        t.operands[0x0D] = ora_abs;
+        t.operands[0x1D] = ora_abs_x;
+        t.operands[0x19] = ora_abs_y;
+        t.operands[0x01] = ora_x_ind;
+        t.operands[0x11] = ora_ind_y;
+
+        t.operands[0x49] = eor_imm;
+        t.operands[0x45] = eor_zpg;
+        t.operands[0x55] = eor_zpg_x;
+        t.operands[0x4D] = eor_abs;
+        t.operands[0x5D] = eor_abs_x;
+        t.operands[0x59] = eor_abs_y;
+        t.operands[0x41] = eor_x_ind;
+        t.operands[0x51] = eor_ind_y;
+
+        t.operands[0xC9] = cmp_imm;
+        t.operands[0xC5] = cmp_zpg;
+        t.operands[0xD5] = cmp_zpg_x;
+        t.operands[0xCD] = cmp_abs;
+        t.operands[0xDD] = cmp_abs_x;
+        t.operands[0xD9] = cmp_abs_y;
+        t.operands[0xC1] = cmp_x_ind;
+        t.operands[0xD1] = cmp_ind_y;
+
+        t.operands[0xE0] = cpx_imm;
+        t.operands[0xE4] = cpx_zpg;
+        t.operands[0xEC] = cpx_abs;
+
+        t.operands[0xC0] = cpy_imm;
+        t.operands[0xC4] = cpy_zpg;
+        t.operands[0xCC] = cpy_abs;
+
+        t.operands[0x48] = pha;
+        t.operands[0x08] = php;
+        t.operands[0x68] = pla;
+        t.operands[0x28] = plp;
+
+        t.operands[0xAA] = tax;
+        t.operands[0x8A] = txa;
+        t.operands[0xA8] = tay;
+        t.operands[0x98] = tya;
+        t.operands[0xBA] = tsx;
+        t.operands[0x9A] = txs;
+
+        t.operands[0x0A] = asl_a;
+        t.operands[0x06] = asl_zpg;
+        t.operands[0x16] = asl_zpg_x;
+        t.operands[0x0E] = asl_abs;
+        t.operands[0x1E] = asl_abs_x;
+
+        t.operands[0x4A] = lsr_a;
+        t.operands[0x46] = lsr_zpg;
+        t.operands[0x56] = lsr_zpg_x;
+        t.operands[0x4E] = lsr_abs;
+        t.operands[0x5E] = lsr_abs_x;
+
+        t.operands[0x2A] = rol_a;
+        t.operands[0x26] = rol_zpg;
+        t.operands[0x36] = rol_zpg_x;
+        t.operands[0x2E] = rol_abs;
+        t.operands[0x3E] = rol_abs_x;
+
+        t.operands[0x6A] = ror_a;
+        t.operands[0x66] = ror_zpg;
+        t.operands[0x76] = ror_zpg_x;
+        t.operands[0x6E] = ror_abs;
+        t.operands[0x7E] = ror_abs_x;
+
+        t.operands[0xC6] = dec_zpg;
+        t.operands[0xD6] = dec_zpg_x;
+        t.operands[0xCE] = dec_abs;
+        t.operands[0xDE] = dec_abs_x;
+        t.operands[0xCA] = dex;
+        t.operands[0x88] = dey;
+
+        t.operands[0xE6] = inc_zpg;
+        t.operands[0xF6] = inc_zpg_x;
+        t.operands[0xEE] = inc_abs;
+        t.operands[0xFE] = inc_abs_x;
+        t.operands[0xE8] = inx;
+        t.operands[0xC8] = iny;
+
+        t.operands[0x24] = bit_zpg;
+        t.operands[0x2C] = bit_abs;
+
+        t.operands[0x18] = clc;
+        t.operands[0x58] = cli;
+        t.operands[0xB8] = clv;
+        t.operands[0x38] = sec;
+        t.operands[0x78] = sei;
+
+        if (supportBCD) {
+            t.operands[0xD8] = cld;
+            t.operands[0xF8] = sed;
+        }
+
+        t.operands[0x10] = bpl_rel;
+        t.operands[0x30] = bmi_rel;
+        t.operands[0x50] = bvc_rel;
+        t.operands[0x70] = bvs_rel;
+        t.operands[0x90] = bcc_rel;
+        t.operands[0xB0] = bcs_rel;
+        t.operands[0xD0] = bne_rel;
+        t.operands[0xF0] = beq_rel;
+
+        t.operands[0x4C] = jmp_abs;
+        t.operands[0x6C] = jmp_ind;
+        t.operands[0x20] = jsr_abs;
+        t.operands[0x60] = rts;
+        t.operands[0x00] = brk;
+        t.operands[0x40] = rti;
+
+        t.operands[0xEA] = nop;
+        return t;
+    }
+};
+
+template <class Bus, int Mode, int Features>
+constexpr typename M6502T<Bus, Mode, Features>::OperandTable M6502T<Bus, Mode, Features>::operandTables[2] = {
+    M6502T<Bus, Mode, Features>::makeOperandTable(true),
+    M6502T<Bus, Mode, Features>::makeOperandTable(false),
+};
+
+template <class Bus, int Mode, int Features>
+constexpr typename M6502T<Bus, Mode, Features>::FlagTable M6502T<Bus, Mode, Features>::flagTable = M6502T<Bus, Mode, Features>::makeFlagTable();
+
+/**
+ * MOS6502 core with the callback functions for the memory bus
+ */
+class M6502 : public M6502T<M6502CallbackBus>
+{
+  public:
+    /**
+     * Constructor
+     * - [i] mode: emulation mode (Specify M6502_MODE_XXX)
+     * - [i] readMemory: callback function pointer of read memory
+     * - [i] writeMemory: callback function pointer of write memory
+     * - [i] arg: argument when calling the callback functions
+     */
+    M6502(int mode, unsigned char (*readMemory)(void* arg, unsigned short addr), void (*writeMemory)(void* arg, unsigned short addr, unsigned char value), void* arg)
+        : M6502T<M6502CallbackBus>(mode, M6502CallbackBus(readMemory, writeMemory, arg), arg)
+    {
     }
 };
 
@@ -50,13 +50,43 @@ class TestMMU
 };
 
 static int totalClocks;
-static unsigned char readMemory(void* arg, unsigned short addr) { return ((TestMMU*)arg)->readMemory(addr); }
+static int totalReads;
+static unsigned char readMemory(void* arg, unsigned short addr) { return totalReads++, ((TestMMU*)arg)->readMemory(addr); }
 static void writeMemory(void* arg, unsigned short addr, unsigned char value) { ((TestMMU*)arg)->writeMemory(addr, value); }
 static void consumeClock(void* arg) { totalClocks++; }
+
+// adds the distinct catch-up callbacks and returns the number of the accepted callbacks
+template <int N>
+static void emptyCatchUp(void* arg, int clocks) {}
+template <class CPU, size_t... N>
+static int addCatchUps(CPU* cpu, std::index_sequence<N...>)
+{
+    bool added[] = {cpu->addCatchUp(0x5000, 0x5000, emptyCatchUp<N>)...};
+    return (int)std::count(added, added + sizeof(added), true);
+}
+
+// compile-time memory bus that accesses TestMMU without the callbacks (M6502T<TestBus>)
+struct TestBus {
+    TestMMU* mmu;
+    TestBus(TestMMU* mmu) : mmu(mmu) {}
+    inline unsigned char read(unsigned short addr) { return totalReads++, mmu->readMemory(addr); }
+    inline void write(unsigned short addr, unsigned char value) { mmu->writeMemory(addr, value); }
+};
+
+// callback core of the NORMAL mode with the given features that accesses TestMMU (write can be hooked)
+template <int Features>
+class TestCPU : public M6502T<M6502CallbackBus, M6502_MODE_NORMAL, Features>
+{
+  public:
+    TestCPU(TestMMU* mmu, void (*write)(void* arg, unsigned short addr, unsigned char value) = writeMemory)
+        : M6502T<M6502CallbackBus, M6502_MODE_NORMAL, Features>(M6502CallbackBus(readMemory, write, mmu), mmu) {}
+};
 static void debugMessage(void* arg, const char* message) { printf("%s\n", message); }
-static void printRegister(M6502* cpu, FILE* fp = stdout) { fprintf(fp, "<REGISTER-DUMP> PC:$%04X A:$%02X X:$%02X Y:$%02X S:$%02X P:$%02X\n", cpu->R.pc, cpu->R.a, cpu->R.x, cpu->R.y, cpu->R.s, cpu->R.p); }
+template <class CPU>
+static void printRegister(CPU* cpu, FILE* fp = stdout) { fprintf(fp, "<REGISTER-DUMP> PC:$%04X A:$%02X X:$%02X Y:$%02X S:$%02X P:$%02X\n", cpu->R.pc, cpu->R.a, cpu->R.x, cpu->R.y, cpu->R.s, cpu->R.p); }
 
-static void check(int line, M6502* cpu, TestMMU* mmu, bool succeed)
+template <class CPU>
+static void check(int line, CPU* cpu, TestMMU* mmu, bool succeed)
 {
     if (!succeed) {
         fprintf(stderr, "TEST FAILED! (line: %d)\n", line);
@@ -72,11 +102,9 @@ static void check(int line, M6502* cpu, TestMMU* mmu, bool succeed)
     len = cpu.R.pc - pc;     \
     printRegister(&cpu)
 
-int main(int argc, char** argv)
+template <class CPU>
+static int test(CPU& cpu, TestMMU& mmu)
 {
-    puts("===== INIT =====");
-    TestMMU mmu;
-    M6502 cpu(M6502_MODE_NORMAL, readMemory, writeMemory, &mmu);
     cpu.setConsumeClock(consumeClock);
     cpu.setDebugMessage(debugMessage);
     cpu.setOnError([](void* arg, int errorCode) {
@@ -3823,9 +3851,52 @@ int main(int argc, char** argv)
             TestMMU* mmu = (TestMMU*)arg;
             mmu->ram[0x00]++;
         });
+        void (*unreached)(void*) = [](void* arg) { ((TestMMU*)arg)->ram[0x00] = 0xFF; };
+        for (int addr = 0xF000; addr < 0xF100; addr++) cpu.addBreakPoint(addr, unreached);
+        cpu.removeBreakPoint(unreached);
         cpu.execute(33);
         CHECK(mmu.ram[0x00] == 2);
         cpu.removeAllBreakPoints();
+        cpu.R.pc = 0xE000;
+        cpu.execute(33);
+        CHECK(mmu.ram[0x00] == 2);
+    }
+
+    puts("\n===== TEST:conditional break-point =====");
+    {
+        static int hit[2];
+        mmu.ram[0xE000] = 0xE8; // INX
+        mmu.ram[0xE001] = 0x4C; // JMP $E000
+        mmu.ram[0xE002] = 0x00;
+        mmu.ram[0xE003] = 0xE0;
+        mmu.ram[0xFE] = 0x80;
+        mmu.ram[0x2002] = 0x80;
+        cpu.R.pc = 0xE000;
+        cpu.R.a = 0x40;
+        cpu.R.x = 0x00;
+        CHECK(cpu.addBreakPoint(0xE000, [](void* arg) { hit[0]++; }, "A == $40 && X < 3"));
+        CHECK(cpu.addBreakPoint(0xE001, [](void* arg) { hit[1]++; }, "hits > 5 && !mem[$2002]")); // not peekable: 0
+        CHECK(!cpu.addBreakPoint(0xE001, [](void* arg) { hit[1]++; }, "A == (X"));
+        CHECK(!cpu.addBreakPoint(0xE001, [](void* arg) { hit[1]++; }, NULL));
+        CHECK(!cpu.addBreakPoint(0xE001, [](void* arg) { hit[1]++; }, "A == $ 10"));
+        CHECK(!cpu.addBreakPoint(0xE001, [](void* arg) { hit[1]++; }, "A == 0x0x10"));
+        CHECK(!cpu.addBreakPoint(0xE001, [](void* arg) { hit[1]++; }, "A == $10000"));
+        cpu.execute(50);
+        CHECK(cpu.R.x == 10);
+        CHECK(hit[0] == 3);
+        CHECK(hit[1] == 5);
+        cpu.removeAllBreakPoints();
+        static int peeked;
+        M6502PagedBus bus(readMemory, writeMemory, &mmu);
+        CHECK(bus.mapMemory(0x0000, 0x00FF, &mmu.ram[0x0000], true));
+        CHECK(bus.mapMemory(0xE000, 0xE0FF, &mmu.ram[0xE000], false));
+        M6502T<M6502PagedBus, M6502_MODE_NORMAL, M6502_FEATURE_DEFAULT> pcpu(bus, &mmu);
+        pcpu.R.pc = 0xE000;
+        CHECK(pcpu.addBreakPoint(0xE001, [](void* arg) { peeked++; }, "mem[$00FE] & $80 && 0x7F < mem[0xFE]"));
+        int reads = totalReads;
+        pcpu.execute(15);
+        CHECK(peeked == 3);
+        CHECK(totalReads == reads); // mem[] does not call the read callback
     }
 
     puts("\n===== TEST:break-operand =====");
@@ -3840,11 +3911,46 @@ int main(int argc, char** argv)
             TestMMU* mmu = (TestMMU*)arg;
             mmu->ram[0x00]++;
         });
+        void (*unreached)(void*) = [](void* arg) { ((TestMMU*)arg)->ram[0x00] = 0xFF; };
+        cpu.addBreakOperand(0x02, unreached);
+        cpu.addBreakOperand(0xEA, unreached);
+        cpu.removeBreakOperand(unreached);
+        cpu.removeBreakOperand(unreached);
         cpu.execute(33);
         CHECK(mmu.ram[0x00] == 2);
         cpu.removeAllBreakOperands();
     }
 
+    puts("\n===== TEST:watch-point =====");
+    {
+        static int watched[2];
+        static unsigned char written;
+        mmu.ram[0xE000] = 0xA5; // LDA $10
+        mmu.ram[0xE001] = 0x10;
+        mmu.ram[0xE002] = 0x85; // STA $11
+        mmu.ram[0xE003] = 0x11;
+        mmu.ram[0xE004] = 0xE6; // INC $12
+        mmu.ram[0xE005] = 0x12;
+        mmu.ram[0x10] = 0x5A;
+        cpu.R.pc = 0xE000;
+        cpu.addWatchPoint(0x0010, 0x0012, M6502_WATCH_READ | M6502_WATCH_WRITE, [](void* arg, int access, unsigned short addr, unsigned char value) {
+            printf("WATCH %s $%04X $%02X\n", access == M6502_WATCH_READ ? "READ" : "WRITE", addr, value);
+            watched[access == M6502_WATCH_READ ? 0 : 1]++;
+        });
+        cpu.addWatchPoint(0x0011, 0x0011, M6502_WATCH_WRITE, [](void* arg, int access, unsigned short addr, unsigned char value) {
+            written = value;
+        });
+        cpu.execute(12);
+        CHECK(watched[0] == 2);  // LDA $10, INC $12
+        CHECK(watched[1] == 3);  // STA $11, INC $12 (dummy write and write)
+        CHECK(written == 0x5A);
+        cpu.removeAllWatchPoints();
+        cpu.R.pc = 0xE000;
+        cpu.execute(12);
+        CHECK(watched[0] == 2);
+        CHECK(watched[1] == 3);
+    }
+
     puts("\n===== TEST:ADC decimal mode =====");
     {
         int clocks, len, pc;
@@ -3954,7 +4060,592 @@ int main(int argc, char** argv)
         CHECK(cpu.R.p == 0b00001001);
     }
 
+    puts("\n===== TEST:compile-time mode and features =====");
+    {
+        static const unsigned char program[] = {
+            0xF8,             // $9B10: SED
+            0x18,             // $9B11: CLC
+            0xA9, 0x09,       // $9B12: LDA #$09
+            0x69, 0x01,       // $9B14: ADC #$01
+            0x85, 0x10,       // $9B16: STA $10
+            0x4C, 0x18, 0x9B, // $9B18: JMP $9B18
+        };
+        memcpy(&mmu.ram[0x9B10], program, sizeof(program));
+        M6502T<TestBus, M6502_MODE_NORMAL, M6502_FEATURE_RELEASE> rcpu(TestBus(&mmu), &mmu);
+        M6502T<TestBus, M6502_MODE_RP2A03, M6502_FEATURE_RELEASE> ncpu(TestBus(&mmu), &mmu);
+        rcpu.R.pc = 0x9B10;
+        ncpu.R.pc = 0x9B11; // SED is an unknown operation of RP2A03
+        ncpu.R.p |= 0b00001000;
+        CHECK(rcpu.execute(14) == 14);
+        printRegister(&rcpu);
+        CHECK(rcpu.R.a == 0x10); // decimal mode
+        CHECK(mmu.ram[0x10] == 0x10);
+        CHECK(rcpu.R.pc == 0x9B18);
+        CHECK(ncpu.execute(12) == 12);
+        printRegister(&ncpu);
+        CHECK(ncpu.R.a == 0x0A); // RP2A03 ignores the decimal flag
+        CHECK(mmu.ram[0x10] == 0x0A);
+        CHECK(ncpu.R.pc == 0x9B18);
+    }
+
+    puts("\n===== TEST:predecode =====");
+    {
+        TestCPU<M6502_FEATURE_DEFAULT | M6502_FEATURE_PREDECODE> pcpu(&mmu);
+        pcpu.addPredecodeArea(0x9000, 0x90FF);
+        // $9000: LDA #$01
+        // $9002: ADC #$01  <- the operand is rewritten by the next STA
+        // $9004: STA $9003
+        // $9007: JMP $9000
+        unsigned char prg[] = {0xA9, 0x01, 0x69, 0x01, 0x8D, 0x03, 0x90, 0x4C, 0x00, 0x90};
+        memcpy(&mmu.ram[0x9000], prg, sizeof(prg));
+        pcpu.R.pc = 0x9000;
+        pcpu.R.p = 0;
+        int reads = totalReads;
+        int clocks = pcpu.execute(11);
+        CHECK(clocks == 11);
+        CHECK(totalReads - reads == 10); // operation bytes are read from the memory bus at first
+        CHECK(mmu.ram[0x9003] == 0x02);
+        CHECK(pcpu.R.pc == 0x9000);
+        reads = totalReads;
+        clocks = pcpu.execute(11);
+        CHECK(clocks == 11);
+        CHECK(totalReads - reads == 2); // LDA, STA and JMP are predecoded, ADC was invalidated by STA
+        CHECK(pcpu.R.a == 0x03);
+        CHECK(mmu.ram[0x9003] == 0x03);
+        reads = totalReads;
+        clocks = pcpu.execute(11);
+        CHECK(clocks == 11);
+        CHECK(totalReads - reads == 2);
+        CHECK(pcpu.R.a == 0x04);
+        CHECK(mmu.ram[0x9003] == 0x04);
+        printRegister(&pcpu);
+    }
+
+    puts("\n===== TEST:block engine =====");
+    {
+        TestCPU<M6502_FEATURE_DEFAULT | M6502_FEATURE_PREDECODE> bcpu(&mmu);
+        bcpu.addPredecodeArea(0x9000, 0x90FF);
+        bcpu.setEngine(M6502_ENGINE_BLOCK);
+        mmu.ram[0x9003] = 0x01;
+        bcpu.R.pc = 0x9000;
+        bcpu.R.p = 0;
+        for (int i = 0; i < 4; i++) {
+            unsigned int tickCount = bcpu.R.tickCount;
+            CHECK(bcpu.execute(11) == 11);
+            CHECK(bcpu.R.tickCount - tickCount == 4);
+            CHECK(bcpu.R.pc == 0x9000);
+            CHECK(bcpu.R.a == i + 2);
+            CHECK(mmu.ram[0x9003] == i + 2);
+        }
+        printRegister(&bcpu);
+    }
+
+    puts("\n===== TEST:jit engine =====");
+    {
+        static const unsigned char program[] = {
+            0xA2, 0x00,       // $9100: LDX #$00
+            0xE8,             // $9102: INX
+            0x86, 0x10,       // $9103: STX $10
+            0xA5, 0x10,       // $9105: LDA $10
+            0x69, 0x01,       // $9107: ADC #$01
+            0x8D, 0x00, 0x03, // $9109: STA $0300
+            0xE0, 0x40,       // $910C: CPX #$40
+            0xD0, 0xF2,       // $910E: BNE $9102
+            0x4C, 0x10, 0x91, // $9110: JMP $9110
+        };
+        memcpy(&mmu.ram[0x9100], program, sizeof(program));
+        typedef TestCPU<M6502_FEATURE_DEFAULT | M6502_FEATURE_PREDECODE> PredecodeCPU;
+        static PredecodeCPU* observed;
+        static unsigned long long clockSum;
+        static unsigned long long tickSum;
+        auto observe = [](void* arg, unsigned short addr, unsigned char value) {
+            if (addr == 0x0300) {
+                clockSum += observed->getClock();
+                tickSum += observed->R.tickCount;
+            }
+            writeMemory(arg, addr, value);
+        };
+        PredecodeCPU bcpu(&mmu, observe);
+        PredecodeCPU jcpu(&mmu, observe);
+        bcpu.addPredecodeArea(0x9100, 0x91FF);
+        jcpu.addPredecodeArea(0x9100, 0x91FF);
+        bcpu.setEngine(M6502_ENGINE_BLOCK);
+        jcpu.setEngine(M6502_ENGINE_JIT);
+        bcpu.R.pc = jcpu.R.pc = 0x9100;
+        bcpu.R.p = jcpu.R.p = 0;
+        int reads = totalReads;
+        observed = &bcpu;
+        clockSum = tickSum = 0;
+        int clocks = bcpu.execute(2000);
+        reads = totalReads - reads;
+        unsigned char result = mmu.ram[0x0300];
+        unsigned long long clockSumOfBlock = clockSum;
+        unsigned long long tickSumOfBlock = tickSum;
+        CHECK(bcpu.R.x == 0x40);
+        CHECK(result == 0x41);
+        mmu.ram[0x0300] = 0;
+        int jreads = totalReads;
+        observed = &jcpu;
+        clockSum = tickSum = 0;
+        CHECK(jcpu.execute(2000) == clocks);
+        CHECK(totalReads - jreads == reads);
+        CHECK(mmu.ram[0x0300] == result);
+        CHECK(0 == memcmp(&bcpu.R, &jcpu.R, sizeof(bcpu.R)));
+        CHECK(clockSum == clockSumOfBlock); // the translated code writes back the clocks before the bus access
+        CHECK(tickSum == tickSumOfBlock);
+        printRegister(&jcpu);
+    }
+
+    puts("\n===== TEST:jit engine with a pending interrupt =====");
+    {
+        static const unsigned char program[] = {
+            0xE8, 0xE8, 0xE8, 0xE8, 0xE8, 0xE8, 0xE8, 0xE8, // $9D00: INX x 8
+            0x4C, 0x00, 0x9D,                               // $9D08: JMP $9D00
+        };
+        memcpy(&mmu.ram[0x9D00], program, sizeof(program));
+        mmu.ram[0x9D80] = 0x4C; // $9D80: JMP $9D80 (IRQ handler)
+        mmu.ram[0x9D81] = 0x80;
+        mmu.ram[0x9D82] = 0x9D;
+        unsigned char vector[2] = {mmu.ram[0xFFFE], mmu.ram[0xFFFF]};
+        mmu.ram[0xFFFE] = 0x80;
+        mmu.ram[0xFFFF] = 0x9D;
+        for (int engine = M6502_ENGINE_BLOCK; engine <= M6502_ENGINE_JIT; engine++) {
+            TestCPU<M6502_FEATURE_DEFAULT | M6502_FEATURE_PREDECODE> icpu(&mmu);
+            icpu.addPredecodeArea(0x9D00, 0x9DFF);
+            icpu.setEngine(engine);
+            icpu.R.pc = 0x9D00;
+            icpu.execute(2000); // translate the block
+            icpu.R.pc = 0x9D00;
+            icpu.R.x = 0;
+            icpu.R.p = 0;
+            icpu.IRQ();
+            icpu.execute(30);
+            CHECK(icpu.R.x == 1); // IRQ is taken after the first INX
+            CHECK(icpu.R.pc == 0x9D80);
+        }
+        mmu.ram[0xFFFE] = vector[0];
+        mmu.ram[0xFFFF] = vector[1];
+    }
+
+    puts("\n===== TEST:fusion =====");
+    {
+        static const unsigned char program[] = {
+            0xA0, 0x04,       // $9200: LDY #$04
+            0xA9, 0x55,       // $9202: LDA #$55 (fused with STA)
+            0x8D, 0x10, 0x03, // $9204: STA $0310
+            0x88,             // $9207: DEY (fused with BNE)
+            0xD0, 0xF8,       // $9208: BNE $9202
+            0x4C, 0x0A, 0x92, // $920A: JMP $920A
+        };
+        memcpy(&mmu.ram[0x9200], program, sizeof(program));
+        TestCPU<M6502_FEATURE_DEFAULT | M6502_FEATURE_PREDECODE> tcpu(&mmu);
+        TestCPU<M6502_FEATURE_DEFAULT | M6502_FEATURE_PREDECODE> bcpu(&mmu);
+        tcpu.addPredecodeArea(0x9200, 0x92FF);
+        bcpu.addPredecodeArea(0x9200, 0x92FF);
+        bcpu.setEngine(M6502_ENGINE_BLOCK);
+        tcpu.R.pc = bcpu.R.pc = 0x9200;
+        int clocks = tcpu.execute(45);
+        CHECK(clocks == 45);
+        CHECK(tcpu.R.pc == 0x920A);
+        CHECK(tcpu.R.y == 0x00);
+        CHECK(mmu.ram[0x0310] == 0x55);
+        mmu.ram[0x0310] = 0;
+        CHECK(bcpu.execute(45) == clocks);
+        CHECK(mmu.ram[0x0310] == 0x55);
+        CHECK(0 == memcmp(&tcpu.R, &bcpu.R, sizeof(tcpu.R)));
+        printRegister(&bcpu);
+    }
+
+    puts("\n===== TEST:lazy flags =====");
+    {
+        static const unsigned char program[] = {
+            0xA9, 0x00,       // $9300: LDA #$00
+            0x08,             // $9302: PHP
+            0xA2, 0x80,       // $9303: LDX #$80
+            0x30, 0x01,       // $9305: BMI $9308
+            0xEA,             // $9307: NOP
+            0xC9, 0x01,       // $9308: CMP #$01
+            0x4C, 0x0A, 0x93, // $930A: JMP $930A
+        };
+        memcpy(&mmu.ram[0x9300], program, sizeof(program));
+        TestCPU<M6502_FEATURE_DEFAULT> ecpu(&mmu);
+        TestCPU<M6502_FEATURE_DEFAULT | M6502_FEATURE_LAZY_FLAGS> lcpu(&mmu);
+        ecpu.R.pc = lcpu.R.pc = 0x9300;
+        ecpu.R.p = lcpu.R.p = 0;
+        CHECK(ecpu.execute(12) == 12);
+        unsigned char pushed = mmu.ram[0x0100 + ecpu.R.s + 1];
+        CHECK(pushed == 0x02); // Z
+        CHECK(ecpu.R.pc == 0x930A);
+        CHECK(ecpu.R.p == 0x80); // N
+        mmu.ram[0x0100 + ecpu.R.s + 1] = 0;
+        CHECK(lcpu.execute(12) == 12);
+        CHECK(mmu.ram[0x0100 + lcpu.R.s + 1] == pushed);
+        CHECK(0 == memcmp(&ecpu.R, &lcpu.R, sizeof(ecpu.R)));
+        printRegister(&lcpu);
+    }
+
+    puts("\n===== TEST:page table =====");
+    {
+        static const unsigned char program[] = {
+            0xAD, 0x00, 0x04, // $9400: LDA $0400
+            0x8D, 0x01, 0x04, // $9403: STA $0401
+            0x4C, 0x06, 0x94, // $9406: JMP $9406
+        };
+        memcpy(&mmu.ram[0x9400], program, sizeof(program));
+        mmu.ram[0x0400] = 0x5A;
+        M6502PagedBus bus(readMemory, writeMemory, &mmu);
+        CHECK(!bus.mapMemory(0x0480, 0x04FF, &mmu.ram[0x0480], true)); // not page aligned
+        CHECK(!bus.mapMemory(0x0400, 0x047F, &mmu.ram[0x0400], true)); // not page aligned
+        CHECK(bus.readPages[0x04] == NULL);
+        CHECK(bus.mapMemory(0x0400, 0x04FF, &mmu.ram[0x0400], true));
+        CHECK(bus.mapMemory(0x9400, 0x94FF, &mmu.ram[0x9400], false));
+        unsigned short value = 0;
+        CHECK(bus.read16(0x9401, &value) && value == 0x0400); // operand of LDA $0400 in the mapped page
+        CHECK(!bus.read16(0x94FF, &value));                   // crosses the page
+        CHECK(!bus.read16(0x9500, &value));                   // not mapped
+        M6502T<M6502PagedBus, M6502_MODE_NORMAL, M6502_FEATURE_DEFAULT> mcpu(bus, &mmu);
+        mcpu.R.pc = 0x9400;
+        int reads = totalReads;
+        CHECK(mcpu.execute(8) == 8);
+        CHECK(totalReads == reads); // the mapped pages do not call the callback
+        CHECK(mcpu.R.pc == 0x9406);
+        CHECK(mmu.ram[0x0401] == 0x5A);
+        CHECK(mcpu.bus.unmapMemory(0x9400, 0x94FF));
+        CHECK(mcpu.execute(3) == 3);
+        CHECK(totalReads == reads + 3);
+        printRegister(&mcpu);
+    }
+
+    puts("\n===== TEST:low memory =====");
+    {
+        static const unsigned char program[] = {
+            0xA2, 0x02,       // $9500: LDX #$02
+            0xA1, 0x10,       // $9502: LDA ($10,X)
+            0x48,             // $9504: PHA
+            0x20, 0x0B, 0x95, // $9505: JSR $950B
+            0x4C, 0x08, 0x95, // $9508: JMP $9508
+            0x68,             // $950B: PLA
+            0x85, 0x20,       // $950C: STA $20
+            0x68,             // $950E: PLA
+            0x85, 0x21,       // $950F: STA $21
+            0xA5, 0x21,       // $9511: LDA $21
+            0x48,             // $9513: PHA
+            0xA5, 0x20,       // $9514: LDA $20
+            0x48,             // $9516: PHA
+            0x60,             // $9517: RTS
+        };
+        memcpy(&mmu.ram[0x9500], program, sizeof(program));
+        static unsigned char low[0x200];
+        low[0x12] = 0x00;
+        low[0x13] = 0x96;
+        mmu.ram[0x9600] = 0xA5;
+        TestCPU<M6502_FEATURE_DEFAULT | M6502_FEATURE_LOW_MEMORY> lcpu(&mmu);
+        lcpu.setLowMemory(low);
+        lcpu.R.pc = 0x9500;
+        lcpu.R.s = 0xFF;
+        int reads = totalReads;
+        CHECK(lcpu.execute(49) == 49);
+        CHECK(totalReads - reads == 22); // operation bytes and the target of ($10,X) only
+        CHECK(lcpu.R.pc == 0x9508);
+        CHECK(lcpu.R.s == 0xFE);
+        CHECK(low[0x20] == 0x95);
+        CHECK(low[0x21] == 0x08);
+        CHECK(low[0x1FF] == 0xA5);
+        printRegister(&lcpu);
+    }
+
+    puts("\n===== TEST:low memory with lazy flags =====");
+    {
+        static const unsigned char program[] = {
+            0xA9, 0x02,       // $9E00: LDA #$02 (Z of P)
+            0x48,             // $9E02: PHA
+            0xA9, 0x01,       // $9E03: LDA #$01
+            0x28,             // $9E05: PLP
+            0xF0, 0x02,       // $9E06: BEQ $9E0A
+            0xA0, 0x01,       // $9E08: LDY #$01
+            0x4C, 0x0A, 0x9E, // $9E0A: JMP $9E0A
+        };
+        memcpy(&mmu.ram[0x9E00], program, sizeof(program));
+        static unsigned char low[0x200];
+        TestCPU<M6502_FEATURE_DEFAULT | M6502_FEATURE_PREDECODE | M6502_FEATURE_LAZY_FLAGS | M6502_FEATURE_LOW_MEMORY> lcpu(&mmu);
+        lcpu.setLowMemory(low);
+        lcpu.addPredecodeArea(0x9E00, 0x9EFF);
+        for (int i = 0; i < 2; i++) { // the operations are predecoded at the first time
+            lcpu.R.pc = 0x9E00;
+            lcpu.R.s = 0xFF;
+            lcpu.R.y = 0x00;
+            lcpu.execute(20);
+            CHECK(lcpu.R.y == 0x00); // BEQ tests Z pulled by PLP
+            CHECK(lcpu.R.pc == 0x9E0A);
+            CHECK(lcpu.R.p == 0x02);
+        }
+        printRegister(&lcpu);
+    }
+
+    puts("\n===== TEST:idle skip =====");
+    {
+        static const unsigned char program[] = {
+            0xA5, 0x10, // $9700: LDA $10
+            0xF0, 0xFC, // $9702: BEQ $9700
+        };
+        memcpy(&mmu.ram[0x9700], program, sizeof(program));
+        mmu.ram[0x0010] = 0x00;
+        TestCPU<M6502_FEATURE_DEFAULT | M6502_FEATURE_PREDECODE> ncpu(&mmu);
+        TestCPU<M6502_FEATURE_DEFAULT | M6502_FEATURE_PREDECODE | M6502_FEATURE_IDLE_SKIP> icpu(&mmu);
+        ncpu.addPredecodeArea(0x9700, 0x97FF);
+        icpu.addPredecodeArea(0x9700, 0x97FF);
+        icpu.addStableArea(0x0000, 0x00FF);
+        ncpu.R.pc = icpu.R.pc = 0x9700;
+        int clocks = ncpu.execute(100);
+        int reads = totalReads;
+        CHECK(icpu.execute(100) == clocks);
+        CHECK(totalReads - reads < 10); // the idle iterations were skipped
+        CHECK(0 == memcmp(&ncpu.R, &icpu.R, sizeof(ncpu.R)));
+        mmu.ram[0x0010] = 0x01; // the loop exits after the memory was changed
+        CHECK(ncpu.execute(6) == icpu.execute(6));
+        CHECK(0 == memcmp(&ncpu.R, &icpu.R, sizeof(ncpu.R)));
+        CHECK(icpu.R.a == 0x01);
+        printRegister(&icpu);
+    }
+
+    puts("\n===== TEST:batched clocks =====");
+    {
+        static const unsigned char program[] = {
+            0xA9, 0x01,       // $9800: LDA #$01
+            0x8D, 0x00, 0x40, // $9802: STA $4000
+            0xE8,             // $9805: INX
+            0x4C, 0x00, 0x98, // $9806: JMP $9800
+        };
+        memcpy(&mmu.ram[0x9800], program, sizeof(program));
+        static int batched;
+        static int synced;
+        TestCPU<M6502_FEATURE_DEFAULT | M6502_FEATURE_CLOCK_SYNC> bcpu(&mmu, [](void* arg, unsigned short addr, unsigned char value) {
+            if (addr == 0x4000 && synced < 0) synced = batched;
+            writeMemory(arg, addr, value);
+        });
+        bcpu.setConsumeClocks([](void* arg, int clocks) { batched += clocks; });
+        bcpu.addClockSyncArea(0x4000, 0x4000);
+        bcpu.R.pc = 0x9800;
+        batched = 0;
+        synced = -1;
+        int reset = (int)bcpu.getClock();
+        CHECK(bcpu.stall(3) == 3);
+        CHECK(batched == reset + 3); // the clocks of reset and the stall before the first execute
+        batched = 0;
+        int clocks = bcpu.execute(100);
+        CHECK(batched == clocks);
+        CHECK(synced == 5); // LDA #$01 (2) + STA $4000 (3 before the write cycle)
+        bcpu.setConsumeClock(consumeClock); // the per-clock callback takes priority
+        int clocksBefore = totalClocks;
+        int batchedBefore = batched;
+        clocks = bcpu.execute(100);
+        CHECK(totalClocks - clocksBefore == clocks);
+        CHECK(batched == batchedBefore);
+        printRegister(&bcpu);
+    }
+    {
+        static const unsigned char program[] = {
+            0xA2, 0x10,       // $9810: LDX #$10
+            0xCA,             // $9812: DEX
+            0xD0, 0xFD,       // $9813: BNE $9812
+            0x4C, 0x15, 0x98, // $9815: JMP $9815
+        };
+        memcpy(&mmu.ram[0x9810], program, sizeof(program));
+        static int maxBatched;
+        TestCPU<M6502_FEATURE_DEFAULT | M6502_FEATURE_PREDECODE> bcpu(&mmu);
+        bcpu.addPredecodeArea(0x9800, 0x98FF);
+        bcpu.setEngine(M6502_ENGINE_BLOCK);
+        bcpu.setConsumeClocks([](void* arg, int clocks) { maxBatched = clocks < maxBatched ? maxBatched : clocks; });
+        bcpu.R.pc = 0x9810;
+        bcpu.execute(1);
+        maxBatched = 0;
+        bcpu.execute(100);
+        CHECK(bcpu.R.x == 0);
+        CHECK(maxBatched == 3); // DEX/BNE are fused but notified at each operation boundary
+    }
+
+    puts("\n===== TEST:event =====");
+    {
+        static const unsigned char program[] = {
+            0xEA, 0xEA, 0xEA, 0xEA, // $9900: NOP x 4
+            0x4C, 0x00, 0x99,       // $9904: JMP $9900
+        };
+        memcpy(&mmu.ram[0x9900], program, sizeof(program));
+        static M6502* ecpu;
+        static int fired;
+        static unsigned long long firedAt[4];
+        M6502 cpu2(M6502_MODE_NORMAL, readMemory, writeMemory, &mmu);
+        ecpu = &cpu2;
+        fired = 0;
+        ecpu->R.pc = 0x9900;
+        unsigned long long base = ecpu->getClock();
+        void (*callback)(void*) = [](void* arg) { firedAt[fired++] = ecpu->getClock(); };
+        ecpu->addEvent(base + 70, callback);
+        ecpu->addEvent(base + 10, callback);
+        ecpu->addEvent(base + 300, [](void* arg) { fired = 100; });
+        ecpu->addEvent(base + 40, callback);
+        int clocks = ecpu->execute(100);
+        CHECK(100 <= clocks && clocks < 103);
+        CHECK(ecpu->getClock() == base + clocks);
+        CHECK(fired == 3);
+        CHECK(base + 10 <= firedAt[0] && firedAt[0] < base + 13); // fired at the boundary of the operations
+        CHECK(base + 40 <= firedAt[1] && firedAt[1] < base + 43);
+        CHECK(base + 70 <= firedAt[2] && firedAt[2] < base + 73);
+        ecpu->removeEvent(callback);
+        ecpu->execute(300);
+        CHECK(fired == 100);
+    }
+
+    puts("\n===== TEST:catch-up =====");
+    {
+        static const unsigned char program[] = {
+            0xA9, 0x01,       // $9A00: LDA #$01
+            0x8D, 0x00, 0x20, // $9A02: STA $2000
+            0xEA,             // $9A05: NOP
+            0x8D, 0x17, 0x40, // $9A06: STA $4017
+            0x4C, 0x09, 0x9A, // $9A09: JMP $9A09
+        };
+        memcpy(&mmu.ram[0x9A00], program, sizeof(program));
+        static int ppuClocks[4];
+        static int ppuCount;
+        static int apuClocks[4];
+        static int apuCount;
+        TestCPU<M6502_FEATURE_DEFAULT | M6502_FEATURE_CLOCK_SYNC> cpu3(&mmu);
+        cpu3.addCatchUp(0x2000, 0x2007, [](void* arg, int clocks) { ppuClocks[ppuCount++] = clocks; });
+        cpu3.addCatchUp(0x4000, 0x4017, [](void* arg, int clocks) { apuClocks[apuCount++] = clocks; });
+        cpu3.R.pc = 0x9A00;
+        ppuCount = 0;
+        apuCount = 0;
+        int clocks = cpu3.execute(30);
+        CHECK(ppuCount == 2);
+        CHECK(ppuClocks[0] == 5); // LDA #$01 (2) + STA $2000 (3 before the write cycle)
+        CHECK(ppuClocks[0] + ppuClocks[1] == clocks);
+        CHECK(apuCount == 2);
+        CHECK(apuClocks[0] == 11); // + the write cycle (1) + NOP (2) + STA $4017 (3 before the write cycle)
+        CHECK(apuClocks[0] + apuClocks[1] == clocks);
+        CHECK(addCatchUps(&cpu3, std::make_index_sequence<256>()) == 253); // up to 255 callbacks including the above 2
+        CHECK(cpu3.addCatchUp(0x5001, 0x5001, emptyCatchUp<0>));           // the added callback can be added to another area
+        printRegister(&cpu3);
+    }
+
+    puts("\n===== TEST:stall =====");
+    {
+        static const unsigned char program[] = {
+            0xA9, 0x02,       // $9B00: LDA #$02
+            0x8D, 0x14, 0x40, // $9B02: STA $4014
+            0x4C, 0x05, 0x9B, // $9B05: JMP $9B05
+        };
+        memcpy(&mmu.ram[0x9B00], program, sizeof(program));
+        static M6502* dcpu;
+        static int stalled;
+        static int batched;
+        static int batchedCount;
+        M6502 cpu4(M6502_MODE_NORMAL, readMemory, [](void* arg, unsigned short addr, unsigned char value) {
+            if (addr == 0x4014) stalled = dcpu->stall(513, true); // OAM DMA
+            writeMemory(arg, addr, value);
+        }, &mmu);
+        dcpu = &cpu4;
+        cpu4.setConsumeClocks([](void* arg, int clocks) { batched += clocks, batchedCount++; });
+        cpu4.R.pc = 0x9B00;
+        stalled = 0;
+        batched = 0;
+        batchedCount = 0;
+        unsigned long long start = cpu4.getClock();
+        int clocks = cpu4.execute(6);
+        CHECK(stalled == ((start + 5) & 1 ? 514 : 513));
+        CHECK(clocks == 6 + stalled);
+        CHECK(batched == (int)start + clocks);
+        CHECK(batchedCount == 4); // reset, LDA, the stall and STA
+    }
+
+    puts("\n===== TEST:trace =====");
+    {
+        static const unsigned char program[] = {
+            0xA2, 0x01,       // $9C00: LDX #$01
+            0xB5, 0x10,       // $9C02: LDA $10,X
+            0x8D, 0x00, 0x03, // $9C04: STA $0300
+            0x6C, 0x00, 0x04, // $9C07: JMP ($0400)
+        };
+        memcpy(&mmu.ram[0x9C00], program, sizeof(program));
+        mmu.ram[0x11] = 0x80;
+        mmu.ram[0x400] = 0x00;
+        mmu.ram[0x401] = 0x9C;
+        static M6502TraceEvent events[4];
+        static int count;
+        TestCPU<M6502_FEATURE_DEFAULT | M6502_FEATURE_TRACE> cpu5(&mmu);
+        cpu5.setTrace([](void* arg, const M6502TraceEvent* event) {
+            if (count < 4) events[count] = *event;
+            count++;
+        });
+        cpu5.R.pc = 0x9C00;
+        count = 0;
+        int clocks = cpu5.execute(16);
+        CHECK(count == 5);
+        CHECK(events[0].before.pc == 0x9C00 && events[0].after.pc == 0x9C02);
+        CHECK(events[0].length == 2 && events[0].code[0] == 0xA2 && events[0].code[1] == 0x01);
+        CHECK(events[0].addr == -1 && events[0].cycles == 2);
+        CHECK(events[0].before.x == 0x00 && events[0].after.x == 0x01);
+        CHECK(events[1].length == 2 && events[1].addr == 0x11 && events[1].cycles == 4);
+        CHECK(events[1].after.a == 0x80 && (events[1].after.p & 0x80));
+        CHECK(events[2].length == 3 && events[2].code[1] == 0x00 && events[2].code[2] == 0x03);
+        CHECK(events[2].addr == 0x0300 && events[2].cycles == 4);
+        CHECK(events[3].addr == 0x0400 && events[3].cycles == 5 && events[3].after.pc == 0x9C00);
+        CHECK(clocks == 2 + 4 + 4 + 5 + 2);
+        printRegister(&cpu5);
+    }
+
+    puts("\n===== TEST:idle skip with low memory =====");
+    {
+        static const unsigned char program[] = {
+            0xA5, 0x10,       // $9F00: LDA $10
+            0xF0, 0xFC,       // $9F02: BEQ $9F00
+            0xE8,             // $9F04: INX
+            0x4C, 0x05, 0x9F, // $9F05: JMP $9F05
+        };
+        memcpy(&mmu.ram[0x9F00], program, sizeof(program));
+        static unsigned char low[0x200];
+        low[0x10] = 0x00;
+        TestCPU<M6502_FEATURE_DEFAULT | M6502_FEATURE_PREDECODE | M6502_FEATURE_LOW_MEMORY | M6502_FEATURE_IDLE_SKIP> icpu(&mmu);
+        icpu.setLowMemory(low);
+        icpu.addPredecodeArea(0x9F00, 0x9FFF);
+        icpu.R.pc = 0x9F00;
+        icpu.R.x = 0x00;
+        icpu.addEvent(icpu.getClock() + 33, [](void* arg) { low[0x10] = 0x01; }); // just after LDA $10 of the 6th iteration
+        icpu.execute(100);
+        CHECK(icpu.R.x == 0x01); // $0010 is not a stable area
+        CHECK(icpu.R.pc == 0x9F05);
+        printRegister(&icpu);
+    }
+
+    puts("\n===== TEST:idle skip with event =====");
+    {
+        mmu.ram[0x0010] = 0x00;
+        TestCPU<M6502_FEATURE_DEFAULT | M6502_FEATURE_PREDECODE | M6502_FEATURE_IDLE_SKIP> icpu(&mmu);
+        icpu.addPredecodeArea(0x9F00, 0x9FFF);
+        icpu.addStableArea(0x0000, 0x00FF); // stable until the next event
+        icpu.R.pc = 0x9F00;
+        icpu.R.x = 0x00;
+        icpu.addEvent(icpu.getClock() + 33, [](void* arg) { ((TestMMU*)arg)->ram[0x0010] = 0x01; }); // just after LDA $10 of the 6th iteration
+        icpu.execute(100);
+        CHECK(icpu.R.x == 0x01);
+        CHECK(icpu.R.pc == 0x9F05);
+        printRegister(&icpu);
+    }
+
     printf("\nTOTAL CLOCKS: %d\nTEST PASSED!\n", totalClocks);
     mmu.outputMemoryDump();
     return 0;
-}
\ No newline at end of file
+}
+
+int main(int argc, char** argv)
+{
+    puts("===== INIT =====");
+    TestMMU mmu;
+    if (1 < argc && 0 == strcmp(argv[1], "bus")) {
+        M6502T<TestBus> cpu(M6502_MODE_NORMAL, TestBus(&mmu), &mmu); // execute the same test with the compile-time bus
+        return test(cpu, mmu);
+    }
+    M6502 cpu(M6502_MODE_NORMAL, readMemory, writeMemory, &mmu);
+    if (1 < argc) cpu.setEngine(atoi(argv[1])); // execute the same test with the other engines
+    return test(cpu, mmu);
+}